@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <sys/stat.h>
 #include <dirent.h>
 #include <errno.h>
@@ -9,22 +10,92 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <time.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
 
 #define MAX_LINE 256 // 최대 명령어 길이
 #define MAX_ARGS 50  // 최대 명령어 인자 수
+#define EXIT_REQUEST -1 // "exit" 명령어 입력 시 run_command_line의 반환값
+
+#define MAX_SESSIONS 1024 // 서버 모드의 최대 동시 접속 수
+#define MAX_VARS 32       // 세션별 최대 변수 수
+#define MAX_JOBS 16       // 세션별 최대 백그라운드 작업 수
+
+#define MAX_SHARDS 64          // 분할 파이프 단계의 최대 작업자 수
+#define SHARD_CHUNK (1 << 20)  // 분할 파이프 단계에서 작업자 하나에 넘기는 입력 크기 (줄 단위로 자름)
+#define SHARD_IDLE_MS 100      // 입력이 이 시간 동안 멈추면 SHARD_CHUNK보다 작아도 모아 둔 줄을 배정
+
+#define ON_CHANGE_DEBOUNCE_MS 100 // on-change: 마지막 변경 이후 이 시간 동안 조용하면 실행
+
+#define MAX_CPU_GROUPS 256 // 캐시를 공유하는 CPU 묶음의 최대 개수
+#define MAX_NUMA_NODES 64  // 최대 NUMA 노드 수
+#define PLACE_PIPELINE 0   // 자동 배치: 파이프라인 단계는 캐시를 공유하는 CPU 묶음 하나에
+#define PLACE_JOB 1        // 자동 배치: 백그라운드 작업은 NUMA 노드를 돌아가며
+
+#define PIPESTAT_OFF 0         // pipestat 계측 꺼짐
+#define PIPESTAT_BYTES 1       // 바이트만 계측 (splice, 데이터 복사 없음)
+#define PIPESTAT_LINES 2       // 줄 수도 계측 (tee 후 읽어서 개행 계산)
+#define PIPESTAT_TICK_MS 50    // 파이프 상태 샘플링 주기
+#define PIPESTAT_DRAW_MS 500   // 상태 줄 갱신 주기
+
+// 단계 사이 파이프 하나의 계측값 (중계 프로세스와 쉘이 공유 메모리로 공유)
+struct pipe_stat {
+    uint64_t bytes, lines;   // 중계한 바이트/줄 수 (중계 프로세스가 갱신)
+    int up_fill, down_fill;  // 앞 단계 쪽/뒤 단계 쪽 파이프에 쌓인 바이트 (FIONREAD)
+    int capacity;            // 파이프 용량 (F_GETPIPE_SZ)
+    int blocked, starved, samples; // 쉘이 샘플링한 상태 횟수
+};
+
+static int pipestat_mode = PIPESTAT_OFF; // pipestat 계측 모드
+
+// 명령어 치환 결과를 담는 버퍼 (memfd를 mmap한 영역, 인자가 직접 가리킴)
+struct capture {
+    char *data;
+    size_t size;
+};
 
 // 함수 선언부
+int run_command_line(char *buf); // 한 줄의 명령어를 실행하고 종료 상태를 반환
+int serve(const char *sock_path); // 유닉스 소켓 서버 모드 실행
 int getargs(char *cmd, char **argv);  // 입력 명령어를 공백으로 분리하는 함수
+char *skip_substitution(char *p); // 명령어 치환 구간을 건너뛴 다음 위치 반환
+int split_pipeline(char *buf, char **commands, int *sharded, int max); // '|' 기준으로 명령어 분리
+int run_sharded(char **argv); // "|| N" 분할 파이프 단계 실행
+int on_change(char *line); // 파일 변경 시 명령어를 다시 실행하는 on-change 내장 명령어
+int take_pin_prefix(char **argv, cpu_set_t *set); // "pin <cpulist>" 접두어를 떼어 내고 CPU 집합 반환
+int auto_placement(int kind, cpu_set_t *set); // 자동 배치 정책에 따른 CPU 집합 선택
+void apply_placement(const cpu_set_t *set); // 현재 프로세스를 CPU 집합에 고정 (exec 전 자식에서 호출)
+void pin_command(char **argv); // pin 내장 명령어 (토폴로지 출력, 자동 배치 켜기/끄기)
+void pipestat_command(char **argv); // pipestat 내장 명령어 (계측 켜기/끄기, 마지막 파이프라인 결과 출력)
+int pipestat_insert_relay(int up_read, struct pipe_stat *st, pid_t *relay); // 파이프 사이에 계측용 중계 프로세스 삽입
+void pipestat_monitor(struct pipe_stat *stats, char **commands, int *sharded, pid_t *pids, int npids, int *status); // 파이프라인 종료 대기 중 상태 표시
+int expand_substitutions(char **argv, struct capture *caps, int *ncaps); // $(...)와 `...`를 출력 결과로 치환
+void release_captures(struct capture *caps, int ncaps); // 치환 결과 버퍼 해제
 int handle_builtin_commands(char **argv);  // 내장 명령어를 처리하는 함수
+int is_builtin(const char *name); // 쉘 안에서 실행되는 내장 명령어인지 확인
 void execute_external_command(char **argv); // 외부 명령어를 실행하는 함수
 void handle_sigint(int sig); // SIGINT(Ctrl-C) 처리
 void handle_sigquit(int sig);  // SIGQUIT 처리
 void handle_sigtstp(int sig);  // SIGTSTP(Ctrl-Z) 처리
 
-int main() {
+int main(int argc, char *argv[]) {
     char buf[MAX_LINE];       // 사용자 입력을 저장할 버퍼
-    char *argv[MAX_ARGS];     // 명령어와 인자를 저장할 배열
-    pid_t pid;                // 프로세스 ID를 저장할 변수
+
+    // --serve 옵션: 유닉스 소켓으로 명령을 받는 서버 모드
+    if (argc == 3 && strcmp(argv[1], "--serve") == 0) {
+        return serve(argv[2]);
+    }
 
     // 시그널 핸들러 등록
     signal(SIGINT, handle_sigint);
@@ -40,120 +111,639 @@ int main() {
         if (!fgets(buf, sizeof(buf), stdin)) break; 
         buf[strcspn(buf, "\n")] = '\0'; // 개행 문자 제거
 
-        if (strlen(buf) == 0) continue; // 빈 입력은 무시
+        if (run_command_line(buf) == EXIT_REQUEST) break; // "exit" 입력 시 프로그램 종료
+    }
+    return 0; // 프로그램 종료
+}
+
+// 한 줄의 명령어를 실행하고 종료 상태를 반환
+int run_command_line(char *buf) {
+    char *argv[MAX_ARGS];     // 명령어와 인자를 저장할 배열
+    pid_t pid;                // 프로세스 ID를 저장할 변수
+    int status = 0;           // 자식 프로세스의 종료 상태
+    struct capture caps[MAX_ARGS]; // 명령어 치환 결과 버퍼
+    int ncaps = 0;
+
+    if (strlen(buf) == 0) return 0; // 빈 입력은 무시
 
-        char *commands[2];
-        int is_pipe = 0; // 파이프 여부를 확인하는 플래그
-        if ((commands[0] = strtok(buf, "|")) && (commands[1] = strtok(NULL, "|"))) {
-            is_pipe = 1; // 파이프 명령어일 경우 플래그 설정
+    // on-change는 "--" 뒤의 명령어를 파이프와 치환까지 그대로 보관해야 하므로 먼저 처리
+    char *first = buf + strspn(buf, " \t");
+    if (strncmp(first, "on-change", 9) == 0 && (first[9] == ' ' || first[9] == '\t' || first[9] == '\0')) {
+        return on_change(first);
+    }
+
+    char *commands[MAX_ARGS];
+    int sharded[MAX_ARGS]; // 단계별 "|| N" 분할 실행 여부
+    int ncommands = split_pipeline(buf, commands, sharded, MAX_ARGS);
+    int is_pipe = ncommands >= 2; // 파이프 여부를 확인하는 플래그
+    if (is_pipe) {
+        char *check[MAX_ARGS];
+        for (int i = 0; i < ncommands; i++) {
+            char copy[MAX_LINE];
+            strcpy(copy, commands[i]);
+            if (getargs(copy, check) == 0) { // 빈 파이프 단계는 문법 오류
+                fprintf(stderr, "syntax error near '|'\n");
+                return EXIT_FAILURE;
+            }
         }
+    }
 
-        if (!is_pipe) { // 파이프가 없는 단일 명령어 처리
-            int narg = getargs(commands[0], argv); // 명령어와 인자를 분리
-            
-            // '&' 처리: 명령어 끝에 &가 있는지 확인
-            int background = 0; // 백그라운드 실행 여부 플래그
-            for (int i = 0; argv[i] != NULL; i++) {
-                if (strcmp(argv[i], "&") == 0) { // '&' 발견 시
-                    background = 1; // 백그라운드 실행 플래그 설정
-                    argv[i] = NULL; // '&'를 제거하여 실행 명령어에서 제외
-                    break;
-                }
+    if (!is_pipe) { // 파이프가 없는 단일 명령어 처리
+        int narg = getargs(commands[0], argv); // 명령어와 인자를 분리
+        if (narg == 0) return 0; // 공백만 입력된 경우 무시
+        if (expand_substitutions(argv, caps, &ncaps) != 0) { // 명령어 치환
+            release_captures(caps, ncaps);
+            return EXIT_FAILURE;
+        }
+        if (argv[0] == NULL) { // 치환 결과가 비어 있는 경우
+            release_captures(caps, ncaps);
+            return 0;
+        }
+
+        // '&' 처리: 명령어 끝에 &가 있는지 확인
+        int background = 0; // 백그라운드 실행 여부 플래그
+        for (int i = 0; argv[i] != NULL; i++) {
+            if (strcmp(argv[i], "&") == 0) { // '&' 발견 시
+                background = 1; // 백그라운드 실행 플래그 설정
+                argv[i] = NULL; // '&'를 제거하여 실행 명령어에서 제외
+                break;
             }
+        }
 
-            if (strcmp(argv[0], "exit") == 0) break; // "exit" 입력 시 프로그램 종료
+        if (strcmp(argv[0], "exit") == 0) { // "exit" 입력 시 종료 요청
+            release_captures(caps, ncaps);
+            return EXIT_REQUEST;
+        }
 
-            if (handle_builtin_commands(argv) == 0) continue; // 내장 명령어 처리
+        // CPU 배치: "pin <cpulist>" 접두어가 우선, 없으면 백그라운드 작업은 자동 배치
+        cpu_set_t placement;
+        int placed = take_pin_prefix(argv, &placement);
+        if (placed && is_builtin(argv[0])) { // 내장 명령어는 쉘 프로세스에서 실행되므로 고정할 수 없음
+            fprintf(stderr, "pin: %s: shell builtins cannot be pinned\n", argv[0]);
+            release_captures(caps, ncaps);
+            return EXIT_FAILURE;
+        }
+        if (!placed && background) placed = auto_placement(PLACE_JOB, &placement);
 
-            // 자식 프로세스 생성
-            pid = fork();
-            if (pid == 0) { // 자식 프로세스
-                // 파일 리다이렉션 처리
-                for (int i = 0; argv[i] != NULL; i++) {
-                    if (strcmp(argv[i], ">") == 0) { // 출력 리다이렉션
-                        int fd = open(argv[i + 1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                        if (fd < 0) {
-                            perror("Failed to open output file");
-                            exit(EXIT_FAILURE);
-                        }
-                        dup2(fd, STDOUT_FILENO);
-                        close(fd);
-                        argv[i] = NULL;
-                        break;
-                    } else if (strcmp(argv[i], "<") == 0) { // 입력 리다이렉션
-                        int fd = open(argv[i + 1], O_RDONLY);
-                        if (fd < 0) {
-                            perror("Failed to open input file");
-                            exit(EXIT_FAILURE);
-                        }
-                        dup2(fd, STDIN_FILENO);
-                        close(fd);
-                        argv[i] = NULL;
-                        break;
+        if (handle_builtin_commands(argv) == 0) { // 내장 명령어 처리
+            release_captures(caps, ncaps);
+            return 0;
+        }
+
+        // 자식 프로세스 생성
+        pid = fork();
+        if (pid == 0) { // 자식 프로세스
+            // 파일 리다이렉션 처리
+            for (int i = 0; argv[i] != NULL; i++) {
+                if (strcmp(argv[i], ">") == 0) { // 출력 리다이렉션
+                    int fd = open(argv[i + 1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                    if (fd < 0) {
+                        perror("Failed to open output file");
+                        exit(EXIT_FAILURE);
                     }
+                    dup2(fd, STDOUT_FILENO);
+                    close(fd);
+                    argv[i] = NULL;
+                    break;
+                } else if (strcmp(argv[i], "<") == 0) { // 입력 리다이렉션
+                    int fd = open(argv[i + 1], O_RDONLY);
+                    if (fd < 0) {
+                        perror("Failed to open input file");
+                        exit(EXIT_FAILURE);
+                    }
+                    dup2(fd, STDIN_FILENO);
+                    close(fd);
+                    argv[i] = NULL;
+                    break;
                 }
-                execute_external_command(argv); // 외부 명령어 실행
-                exit(EXIT_FAILURE);
-            } else if (pid > 0) { // 부모 프로세스
-                if (!background) { // 백그라운드가 아니면 대기
-                    waitpid(pid, NULL, 0); // 자식 프로세스 종료 대기
-                } else { // 백그라운드 실행
-                    printf("[Process running in background with PID %d]\n", pid);
-                }
-            } else {
-                perror("fork failed"); // fork 실패 시 에러 메시지 출력
             }
-        } else { // 파이프 처리
-            int pipe_fd[2]; // 파이프 파일 디스크립터
-            if (pipe(pipe_fd) == -1) {
+            if (placed) apply_placement(&placement); // exec 전에 CPU 고정
+            execute_external_command(argv); // 외부 명령어 실행
+            exit(EXIT_FAILURE);
+        } else if (pid > 0) { // 부모 프로세스
+            if (!background) { // 백그라운드가 아니면 대기
+                waitpid(pid, &status, 0); // 자식 프로세스 종료 대기
+            } else { // 백그라운드 실행
+                printf("[Process running in background with PID %d]\n", pid);
+            }
+        } else {
+            perror("fork failed"); // fork 실패 시 에러 메시지 출력
+            release_captures(caps, ncaps);
+            return EXIT_FAILURE;
+        }
+        release_captures(caps, ncaps);
+    } else { // 파이프 처리 (단계 수 제한 없음)
+        pid_t pids[MAX_ARGS];
+        int prev_read = -1; // 이전 단계 파이프의 읽기 끝
+        cpu_set_t group;    // 자동 배치: 모든 단계가 함께 쓰는 CPU 묶음
+        int grouped = auto_placement(PLACE_PIPELINE, &group);
+        pid_t relays[MAX_ARGS]; // pipestat: 단계 사이의 중계 프로세스
+        int nrelays = 0;
+        struct pipe_stat *stats = NULL; // pipestat: 중계 프로세스와 공유하는 계측값
+        if (pipestat_mode != PIPESTAT_OFF) {
+            stats = mmap(NULL, ncommands * sizeof(struct pipe_stat), PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (stats == MAP_FAILED) stats = NULL;
+        }
+
+        for (int i = 0; i < ncommands; i++) {
+            int pipe_fd[2] = { -1, -1 }; // 다음 단계로 연결할 파이프
+            if (i < ncommands - 1 && pipe(pipe_fd) == -1) {
                 perror("pipe failed");
-                continue;
+                ncommands = i;
+                break;
             }
 
-            pid_t pid1 = fork();
-            if (pid1 == 0) { // 첫 번째 명령어 실행
-                close(pipe_fd[0]); // 읽기 끝 닫기
-                dup2(pipe_fd[1], STDOUT_FILENO); // 표준 출력 파이프 연결
-                close(pipe_fd[1]);
-                char *argv1[MAX_ARGS];
-                getargs(commands[0], argv1);
-                execute_external_command(argv1); // 외부 명령어 실행
+            pids[i] = fork();
+            if (pids[i] == 0) { // i번째 명령어 실행
+                if (prev_read != -1) {
+                    dup2(prev_read, STDIN_FILENO); // 표준 입력 이전 파이프 연결
+                    close(prev_read);
+                }
+                if (pipe_fd[1] != -1) {
+                    close(pipe_fd[0]); // 읽기 끝 닫기
+                    dup2(pipe_fd[1], STDOUT_FILENO); // 표준 출력 파이프 연결
+                    close(pipe_fd[1]);
+                }
+                char *stage_argv[MAX_ARGS];
+                getargs(commands[i], stage_argv);
+                if (expand_substitutions(stage_argv, caps, &ncaps) != 0 || stage_argv[0] == NULL) exit(EXIT_FAILURE);
+                // "|| N" 단계는 작업자들이 병렬로 돌도록 캐시 묶음 하나에 가두지 않음
+                cpu_set_t stage_set;
+                if (!sharded[i] && take_pin_prefix(stage_argv, &stage_set)) apply_placement(&stage_set);
+                else if (grouped && !sharded[i]) apply_placement(&group);
+                if (sharded[i]) exit(run_sharded(stage_argv)); // "|| N" 단계는 N개로 나누어 실행
+                execute_external_command(stage_argv); // 외부 명령어 실행
                 exit(EXIT_FAILURE);
+            } else if (pids[i] < 0) {
+                perror("fork failed");
+                ncommands = i;
+                break;
             }
 
-            pid_t pid2 = fork();
-            if (pid2 == 0) { // 두 번째 명령어 실행
-                close(pipe_fd[1]); // 쓰기 끝 닫기
-                dup2(pipe_fd[0], STDIN_FILENO); // 표준 입력 파이프 연결
-                close(pipe_fd[0]);
-                char *argv2[MAX_ARGS];
-                getargs(commands[1], argv2);
-                execute_external_command(argv2); // 외부 명령어 실행
-                exit(EXIT_FAILURE);
+            // 부모 프로세스에서 사용한 파이프 닫기
+            if (prev_read != -1) close(prev_read);
+            if (pipe_fd[1] != -1) close(pipe_fd[1]);
+            prev_read = pipe_fd[0];
+
+            // pipestat: 다음 단계와의 사이에 중계 프로세스를 넣어 계측
+            if (stats != NULL && prev_read != -1) {
+                prev_read = pipestat_insert_relay(prev_read, &stats[i], &relays[nrelays]);
+                if (relays[nrelays] > 0) nrelays++;
             }
+        }
+        if (prev_read != -1) close(prev_read);
 
-            // 부모 프로세스에서 파이프 닫기
-            close(pipe_fd[0]);
-            close(pipe_fd[1]);
-            wait(NULL); // 첫 번째 자식 프로세스 종료 대기
-            wait(NULL); // 두 번째 자식 프로세스 종료 대기
+        if (stats != NULL) { // 계측 중: 종료를 기다리며 단계별 처리량과 막힘 상태 표시
+            pipestat_monitor(stats, commands, sharded, pids, ncommands, &status);
+            for (int i = 0; i < nrelays; i++) waitpid(relays[i], NULL, 0);
+            munmap(stats, ncommands * sizeof(struct pipe_stat));
+        } else {
+            for (int i = 0; i < ncommands; i++) { // 모든 단계 종료 대기 (마지막 단계의 상태를 반환)
+                waitpid(pids[i], i == ncommands - 1 ? &status : NULL, 0);
+            }
         }
     }
-    return 0; // 프로그램 종료
+
+    // 종료 상태 변환 (시그널로 종료된 경우 128 + 시그널 번호)
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
 }
 
-// 명령어를 공백으로 구분
+// 명령어를 공백으로 구분 (명령어 치환 내부의 공백은 구분하지 않음)
 int getargs(char *cmd, char **argv) {
     int narg = 0;
     while (*cmd) {
         while (*cmd == ' ' || *cmd == '\t') *cmd++ = '\0';
         if (*cmd) argv[narg++] = cmd;
-        while (*cmd && *cmd != ' ' && *cmd != '\t') cmd++;
+        while (*cmd && *cmd != ' ' && *cmd != '\t') cmd = skip_substitution(cmd);
     }
     argv[narg] = NULL;
     return narg;
 }
 
+// p가 $(...) 또는 `...`의 시작이면 그 끝 다음 위치를, 아니면 다음 문자 위치를 반환
+char *skip_substitution(char *p) {
+    if (p[0] == '`') {
+        char *end = strchr(p + 1, '`');
+        return end ? end + 1 : p + strlen(p);
+    }
+    if (p[0] == '$' && p[1] == '(') {
+        int depth = 0; // 중첩된 괄호 깊이
+        for (; *p; p++) {
+            if (*p == '(') depth++;
+            else if (*p == ')' && --depth == 0) return p + 1;
+        }
+        return p; // 닫히지 않은 치환은 줄 끝까지
+    }
+    return p + 1;
+}
+
+// 명령어 치환 밖의 '|'를 기준으로 파이프 단계를 분리하고 단계 수를 반환
+// "||"로 연결된 단계는 sharded[i] = 1로 표시 (분할 실행)
+int split_pipeline(char *buf, char **commands, int *sharded, int max) {
+    int n = 0;
+    sharded[n] = 0;
+    commands[n++] = buf;
+    for (char *p = buf; *p; ) {
+        if (*p == '|' && n < max) {
+            *p++ = '\0';
+            sharded[n] = *p == '|';
+            if (sharded[n]) *p++ = '\0';
+            commands[n++] = p;
+        } else {
+            p = skip_substitution(p);
+        }
+    }
+    return n;
+}
+
+// 명령어를 실행하고 표준 출력을 memfd에 담아 mmap한 버퍼로 반환
+// 내장 명령어는 fork 없이 현재 프로세스에서 실행 (작업 디렉토리는 복원)
+static int capture_output(char *cmd, struct capture *cap) {
+    char copy[MAX_LINE];
+    char *words[MAX_ARGS];
+    snprintf(copy, sizeof(copy), "%s", cmd);
+    int in_process = getargs(copy, words) > 0 && strchr(cmd, '|') == NULL
+                     && (strcmp(words[0], "ls") == 0 || strcmp(words[0], "pwd") == 0
+                         || strcmp(words[0], "cd") == 0 || strcmp(words[0], "mkdir") == 0
+                         || strcmp(words[0], "rmdir") == 0);
+
+    int memfd = memfd_create("substitution", MFD_CLOEXEC);
+    if (memfd < 0) {
+        perror("memfd_create failed");
+        return -1;
+    }
+
+    snprintf(copy, sizeof(copy), "%s", cmd); // run_command_line이 버퍼를 수정하므로 다시 복사
+    fflush(stdout);
+    if (in_process) {
+        int saved_stdout = dup(STDOUT_FILENO);
+        int saved_cwd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        dup2(memfd, STDOUT_FILENO);
+        run_command_line(copy);
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        if (saved_cwd >= 0) {
+            if (fchdir(saved_cwd) == -1) perror("fchdir failed"); // 치환 안의 cd가 쉘 디렉토리를 바꾸지 않도록 복구
+            close(saved_cwd);
+        }
+    } else {
+        pid_t pid = fork();
+        if (pid == 0) { // 자식 프로세스: 출력을 memfd로 연결 후 실행
+            dup2(memfd, STDOUT_FILENO);
+            int status = run_command_line(copy);
+            fflush(stdout);
+            exit(status == EXIT_REQUEST ? 0 : status);
+        } else if (pid < 0) {
+            perror("fork failed");
+            close(memfd);
+            return -1;
+        }
+        waitpid(pid, NULL, 0);
+    }
+
+    // 끝에 '\0'을 붙여 출력 크기만큼 한 번에 매핑 (재할당 및 복사 없음)
+    off_t size = lseek(memfd, 0, SEEK_END);
+    if (size < 0 || pwrite(memfd, "", 1, size) != 1) {
+        perror("capture failed");
+        close(memfd);
+        return -1;
+    }
+    cap->size = size + 1;
+    cap->data = mmap(NULL, cap->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, memfd, 0);
+    close(memfd);
+    if (cap->data == MAP_FAILED) {
+        perror("mmap failed");
+        return -1;
+    }
+    return 0;
+}
+
+// 인자 중 $(...) 또는 `...` 형태를 명령 출력으로 바꾸고 공백 단위로 다시 분리
+// 분리된 단어는 치환 버퍼를 직접 가리키며, 버퍼는 release_captures로 해제
+int expand_substitutions(char **argv, struct capture *caps, int *ncaps) {
+    int narg = 0;
+    while (argv[narg] != NULL) narg++;
+
+    for (int i = 0; i < narg; ) {
+        char *word = argv[i];
+        size_t len = strlen(word);
+        char *inner = NULL;
+        if (len >= 3 && word[0] == '$' && word[1] == '(' && skip_substitution(word) == word + len
+            && word[len - 1] == ')') {
+            word[len - 1] = '\0';
+            inner = word + 2;
+        } else if (len >= 2 && word[0] == '`' && word[len - 1] == '`') {
+            word[len - 1] = '\0';
+            inner = word + 1;
+        }
+        if (inner == NULL) { // 치환이 아닌 일반 인자
+            i++;
+            continue;
+        }
+
+        struct capture *cap = &caps[*ncaps];
+        if (capture_output(inner, cap) != 0) return -1;
+        (*ncaps)++;
+
+        // 출력 버퍼 안에서 단어 분리 (공백, 탭, 개행을 '\0'으로 치환)
+        char *words[MAX_ARGS];
+        int nwords = 0;
+        for (char *p = cap->data; *p; ) {
+            while (*p == ' ' || *p == '\t' || *p == '\n') *p++ = '\0';
+            if (*p == '\0') break;
+            if (nwords == MAX_ARGS) {
+                fprintf(stderr, "substitution: too many arguments\n");
+                return -1;
+            }
+            words[nwords++] = p;
+            while (*p && *p != ' ' && *p != '\t' && *p != '\n') p++;
+        }
+        if (narg - 1 + nwords >= MAX_ARGS) {
+            fprintf(stderr, "substitution: too many arguments\n");
+            return -1;
+        }
+
+        // 치환 인자 자리에 분리된 단어들을 삽입
+        memmove(&argv[i + nwords], &argv[i + 1], (narg - i) * sizeof(char *));
+        memcpy(&argv[i], words, nwords * sizeof(char *));
+        narg += nwords - 1;
+        i += nwords;
+    }
+    return 0;
+}
+
+// 명령어 치환 결과 버퍼 해제
+void release_captures(struct capture *caps, int ncaps) {
+    for (int i = 0; i < ncaps; i++) munmap(caps[i].data, caps[i].size);
+}
+
+// 현재 시각 (밀리초)
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// 분할 실행 중인 작업자 하나 (입력 조각 하나를 처리)
+struct shard_worker {
+    pid_t pid;     // 작업자 프로세스 (0이면 빈 자리)
+    int out_fd;    // 작업자 출력이 담기는 memfd
+    long seq;      // 입력 조각 순번 (출력 순서 유지용)
+};
+
+// 작업자 종료를 기다린 뒤 출력을 표준 출력으로 내보내고 자리를 비움
+static int shard_finish(struct shard_worker *w) {
+    int status;
+    waitpid(w->pid, &status, 0);
+    w->pid = 0;
+
+    off_t size = lseek(w->out_fd, 0, SEEK_END);
+    off_t offset = 0;
+    while (offset < size) { // 커널 안에서 복사 (사용자 공간 버퍼 없음)
+        ssize_t n = sendfile(STDOUT_FILENO, w->out_fd, &offset, size - offset);
+        if (n < 0 && offset == 0 && errno == EINVAL) { // 터미널 등 sendfile 미지원 출력은 read/write로 복사
+            char buffer[4096];
+            while ((n = pread(w->out_fd, buffer, sizeof(buffer), offset)) > 0) {
+                if (write(STDOUT_FILENO, buffer, n) != n) {
+                    n = -1;
+                    break;
+                }
+                offset += n;
+            }
+        }
+        if (n <= 0) {
+            if (n < 0) perror("sendfile failed");
+            break;
+        }
+    }
+    close(w->out_fd);
+
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
+
+// 다음에 출력할 작업자 자리 선택 (순서 유지: 가장 오래된 조각, -u: 먼저 끝난 작업자)
+static int shard_pick(struct shard_worker *workers, int nworkers, int ordered) {
+    int slot = -1;
+    for (int i = 0; i < nworkers; i++) {
+        if (workers[i].pid != 0 && (slot < 0 || workers[i].seq < workers[slot].seq)) slot = i;
+    }
+    if (slot < 0 || ordered) return slot;
+
+    siginfo_t info; // 종료된 작업자를 회수하지 않고 확인만 함 (회수는 shard_finish)
+    if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) == 0) {
+        for (int i = 0; i < nworkers; i++) {
+            if (workers[i].pid == info.si_pid) return i;
+        }
+    }
+    return slot;
+}
+
+// 작업자 종료 상태 합치기: 하나라도 성공(0)하면 단계 전체가 성공, 모두 실패하면 가장 큰 종료 상태
+// grep처럼 일치하는 줄이 없는 조각에서 1을 반환하는 필터도 나누지 않고 실행한 것과 같은 결과가 되도록 함
+struct shard_status {
+    int succeeded; // 성공한 작업자가 있는지
+    int worst;     // 실패한 작업자의 가장 큰 종료 상태
+};
+
+static void shard_collect(struct shard_status *st, int status) {
+    if (status == 0) st->succeeded = 1;
+    else if (status > st->worst) st->worst = status;
+}
+
+// 작업자가 끝났는지 확인 (회수하지 않음, 회수는 shard_finish)
+static int shard_exited(pid_t pid) {
+    siginfo_t info = { 0 };
+    return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid != 0;
+}
+
+// 이미 끝난 작업자의 출력을 내보냄 (순서 유지: 가장 오래된 조각이 끝났을 때만, -u: 끝난 작업자 모두)
+static void shard_drain(struct shard_worker *workers, int nworkers, int ordered, struct shard_status *st) {
+    while (1) {
+        int slot = -1;
+        for (int i = 0; i < nworkers; i++) {
+            if (workers[i].pid == 0) continue;
+            if (ordered) {
+                if (slot < 0 || workers[i].seq < workers[slot].seq) slot = i;
+            } else if (shard_exited(workers[i].pid)) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0 || (ordered && !shard_exited(workers[slot].pid))) return;
+        shard_collect(st, shard_finish(&workers[slot]));
+    }
+}
+
+// 입력을 기다리는 동안 작업자가 끝나면 출력을 바로 내보냄 (느린 입력에서도 결과가 쌓여 있지 않도록)
+// timeout_ms 동안 입력이 없으면 0, 읽을 입력이 있으면 1 반환 (-1이면 입력이 올 때까지 대기)
+static int shard_wait_input(struct shard_worker *workers, int nworkers, int ordered, int sig_fd, int timeout_ms,
+                            struct shard_status *st) {
+    long long deadline = now_ms() + timeout_ms;
+    while (1) {
+        shard_drain(workers, nworkers, ordered, st);
+        struct pollfd pfds[2] = { { STDIN_FILENO, POLLIN, 0 }, { sig_fd, POLLIN, 0 } };
+        long long left = deadline - now_ms();
+        int ready = poll(pfds, sig_fd >= 0 ? 2 : 1, timeout_ms < 0 ? -1 : left > 0 ? (int)left : 0);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return ready < 0; // 오류면 read에서 처리하도록 1
+        if (pfds[0].revents) return 1;
+        struct signalfd_siginfo info; // 작업자 종료 알림만 비우고 다시 확인
+        while (read(sig_fd, &info, sizeof(info)) > 0);
+    }
+}
+
+// 입력 조각을 memfd에 담아 작업자 프로세스를 시작
+static int shard_start(struct shard_worker *w, char **argv, const char *data, size_t len, long seq,
+                       const sigset_t *saved_mask) {
+    int in_fd = memfd_create("shard-in", MFD_CLOEXEC);
+    int out_fd = memfd_create("shard-out", MFD_CLOEXEC);
+    if (in_fd < 0 || out_fd < 0 || write(in_fd, data, len) != (ssize_t)len) {
+        perror("shard: memfd failed");
+        if (in_fd >= 0) close(in_fd);
+        if (out_fd >= 0) close(out_fd);
+        return -1;
+    }
+    lseek(in_fd, 0, SEEK_SET);
+
+    pid_t pid = fork();
+    if (pid == 0) { // 작업자: 입력 조각을 표준 입력으로, 출력은 memfd로
+        sigprocmask(SIG_SETMASK, saved_mask, NULL);
+        dup2(in_fd, STDIN_FILENO);
+        dup2(out_fd, STDOUT_FILENO);
+        execute_external_command(argv);
+        exit(EXIT_FAILURE);
+    }
+    close(in_fd);
+    if (pid < 0) {
+        perror("fork failed");
+        close(out_fd);
+        return -1;
+    }
+    w->pid = pid;
+    w->out_fd = out_fd;
+    w->seq = seq;
+    return 0;
+}
+
+// "|| N [-u] cmd" 단계: 입력을 줄 경계에서 조각으로 나누어 최대 N개의 cmd가 동시에 처리
+// 조각은 비어 있는 작업자 자리에 배정되고, 출력은 기본적으로 입력 순서대로 합침 (-u: 끝난 순서)
+// 조각은 SHARD_CHUNK까지 모으지만, 입력이 잠시 멈추면 모아 둔 완전한 줄을 바로 배정
+// 종료 상태는 shard_collect 규칙 (하나라도 성공하면 0), 입력이 비어 있으면 cmd를 빈 입력으로 한 번 실행
+int run_sharded(char **argv) {
+    char *end;
+    long nworkers = strtol(argv[0], &end, 10);
+    if (*end != '\0' || nworkers < 1 || nworkers > MAX_SHARDS) {
+        fprintf(stderr, "||: usage: || N [-u] command (1 <= N <= %d)\n", MAX_SHARDS);
+        return EXIT_FAILURE;
+    }
+    argv++;
+    int ordered = 1;
+    if (argv[0] != NULL && strcmp(argv[0], "-u") == 0) { // 순서 무시 옵션
+        ordered = 0;
+        argv++;
+    }
+    if (argv[0] == NULL) {
+        fprintf(stderr, "||: missing command\n");
+        return EXIT_FAILURE;
+    }
+
+    struct shard_worker workers[MAX_SHARDS] = { 0 };
+    size_t cap = SHARD_CHUNK;
+    char *buf = malloc(cap);
+    if (buf == NULL) {
+        perror("shard: malloc failed");
+        return EXIT_FAILURE;
+    }
+
+    // 작업자 종료는 SIGCHLD signalfd로 받아 입력 대기와 함께 poll
+    sigset_t mask, saved_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &saved_mask);
+    int sig_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    size_t filled = 0;   // 버퍼에 읽어 둔 크기
+    long next_seq = 0;   // 다음 입력 조각 순번
+    struct shard_status status = { 0, 0 };
+    int failed = 0;      // 작업자를 시작하지 못함
+    int eof = 0;
+
+    while (!eof || filled > 0) {
+        // 버퍼를 채우고 마지막 줄바꿈까지를 조각으로 자름
+        // 완전한 줄이 있으면 SHARD_IDLE_MS까지만, 없으면 입력이 올 때까지 대기
+        while (!eof && filled < cap) {
+            int have_line = filled > 0 && memchr(buf, '\n', filled) != NULL;
+            if (!shard_wait_input(workers, nworkers, ordered, sig_fd, have_line ? SHARD_IDLE_MS : -1, &status)) break;
+            ssize_t n = read(STDIN_FILENO, buf + filled, cap - filled);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) eof = 1;
+            else filled += n;
+        }
+        size_t chunk = filled;
+        if (!eof) {
+            char *nl = memrchr(buf, '\n', filled);
+            if (nl == NULL) { // 한 줄이 버퍼보다 긴 경우 버퍼를 키워서 다시 읽기
+                char *bigger = realloc(buf, cap * 2);
+                if (bigger == NULL) {
+                    perror("shard: realloc failed");
+                    break;
+                }
+                buf = bigger;
+                cap *= 2;
+                continue;
+            }
+            chunk = nl - buf + 1;
+        }
+        if (chunk == 0) break;
+
+        // 비어 있는 작업자 자리 찾기 (없으면 하나가 끝날 때까지 대기)
+        int slot = -1;
+        for (int i = 0; i < nworkers && slot < 0; i++) {
+            if (workers[i].pid == 0) slot = i;
+        }
+        if (slot < 0) {
+            slot = shard_pick(workers, nworkers, ordered);
+            shard_collect(&status, shard_finish(&workers[slot]));
+        }
+
+        if (shard_start(&workers[slot], argv, buf, chunk, next_seq++, &saved_mask) != 0) {
+            failed = 1;
+            break;
+        }
+        memmove(buf, buf + chunk, filled - chunk); // 남은 불완전한 줄은 다음 조각으로
+        filled -= chunk;
+    }
+
+    // 입력이 없었으면 빈 입력으로 한 번 실행 (wc 출력, grep 종료 상태 등을 그대로 얻기 위해)
+    if (next_seq == 0 && !failed && shard_start(&workers[0], argv, buf, 0, next_seq++, &saved_mask) != 0) {
+        failed = 1;
+    }
+
+    // 남은 작업자 출력 정리
+    int slot;
+    while ((slot = shard_pick(workers, nworkers, ordered)) >= 0) {
+        shard_collect(&status, shard_finish(&workers[slot]));
+    }
+    if (sig_fd >= 0) close(sig_fd);
+    sigprocmask(SIG_SETMASK, &saved_mask, NULL);
+    free(buf);
+    if (failed) return EXIT_FAILURE;
+    return status.succeeded ? 0 : status.worst;
+}
+
+// handle_builtin_commands가 쉘 프로세스 안에서 처리하는 명령어 (exit 포함)
+int is_builtin(const char *name) {
+    static const char *names[] = { "exit", "ls", "pwd", "cd", "mkdir", "rmdir", "pin", "pipestat", NULL };
+    for (int i = 0; names[i] != NULL; i++) {
+        if (strcmp(name, names[i]) == 0) return 1;
+    }
+    return 0;
+}
+
 // 내장 명령어 처리 함수
 int handle_builtin_commands(char **argv) {
     // ls 명령어: 현재 디렉토리의 파일 및 디렉토리 목록 출력
@@ -214,6 +804,19 @@ int handle_builtin_commands(char **argv) {
         return 0;
     }
 
+    // pin 명령어: CPU 토폴로지와 자동 배치 상태 출력, 자동 배치 켜기/끄기
+    // (명령어 앞에 붙는 "pin <cpulist> <command>" 형태는 run_command_line에서 처리)
+    if (strcmp(argv[0], "pin") == 0) {
+        pin_command(argv);
+        return 0;
+    }
+
+    // pipestat 명령어: 파이프 계측 켜기/끄기 (on [-l] | off), 인자가 없으면 마지막 파이프라인 결과 출력
+    if (strcmp(argv[0], "pipestat") == 0) {
+        pipestat_command(argv);
+        return 0;
+    }
+
     return 1; // 해당 명령어가 처리되지 않았음을 반환
 }
 
@@ -340,4 +943,975 @@ void handle_sigquit(int sig) {
 // 시그널 핸들러: SIGTSTP
 void handle_sigtstp(int sig) {
     printf("\nCaught signal %d (SIGTSTP). Stopping is disabled. Resuming...\n", sig);
-}
\ No newline at end of file
+}
+
+// /sys/devices/system/cpu에서 읽은 CPU 토폴로지
+struct cpu_topology {
+    int loaded;
+    cpu_set_t online;                       // 온라인 CPU
+    cpu_set_t caches[MAX_CPU_GROUPS];       // 마지막 레벨 캐시(L3, 없으면 L2)를 공유하는 CPU 묶음
+    int ncaches;
+    cpu_set_t nodes[MAX_NUMA_NODES];        // NUMA 노드별 CPU
+    int nnodes;
+};
+
+static struct cpu_topology topology;
+static int auto_place = 0;      // 자동 배치 사용 여부 (pin auto / pin off)
+static int next_cache_group = 0; // 다음 파이프라인에 배정할 캐시 묶음 (돌아가며 배정)
+static int next_node = 0;        // 다음 백그라운드 작업에 배정할 NUMA 노드
+
+// "0-3,8,10-11" 형식의 CPU 목록 해석 (잘못된 형식이면 -1)
+static int parse_cpulist(const char *s, cpu_set_t *set) {
+    CPU_ZERO(set);
+    while (*s && *s != '\n') {
+        char *end;
+        long first = strtol(s, &end, 10), last = first;
+        if (end == s || first < 0) return -1;
+        if (*end == '-') {
+            s = end + 1;
+            last = strtol(s, &end, 10);
+            if (end == s || last < first) return -1;
+        }
+        if (last >= CPU_SETSIZE) return -1;
+        for (long cpu = first; cpu <= last; cpu++) CPU_SET(cpu, set);
+        s = end;
+        if (*s == ',') s++;
+        else if (*s && *s != '\n') return -1;
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// sysfs 파일 한 줄 읽기
+static int read_sysfs(const char *path, char *buf, size_t size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+// CPU 집합을 "0-3,8" 형식 문자열로 변환
+static void format_cpulist(const cpu_set_t *set, char *buf, size_t size) {
+    size_t used = 0;
+    buf[0] = '\0';
+    for (int cpu = 0; cpu < CPU_SETSIZE && used < size; cpu++) {
+        if (!CPU_ISSET(cpu, set)) continue;
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) last++;
+        used += snprintf(buf + used, size - used, used ? ",%d" : "%d", cpu);
+        if (last > cpu && used < size) used += snprintf(buf + used, size - used, "-%d", last);
+        cpu = last;
+    }
+}
+
+// CPU 토폴로지를 처음 사용할 때 한 번 읽음
+static void load_topology(void) {
+    char path[PATH_MAX], value[4096];
+    if (topology.loaded) return;
+    topology.loaded = 1;
+    if (read_sysfs("/sys/devices/system/cpu/online", value, sizeof(value)) != 0
+        || parse_cpulist(value, &topology.online) != 0) {
+        sched_getaffinity(0, sizeof(topology.online), &topology.online);
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &topology.online)) continue;
+
+        // 가장 높은 레벨의 데이터/통합 캐시를 공유하는 CPU 묶음
+        int best_level = 0;
+        cpu_set_t shared;
+        for (int index = 0; index < 16; index++) {
+            char type[32], level[16], list[4096];
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+            if (read_sysfs(path, level, sizeof(level)) != 0) break;
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, index);
+            if (read_sysfs(path, type, sizeof(type)) != 0 || strcmp(type, "Instruction") == 0) continue;
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+            cpu_set_t candidate;
+            if (atoi(level) > best_level && atoi(level) <= 3 && read_sysfs(path, list, sizeof(list)) == 0
+                && parse_cpulist(list, &candidate) == 0) {
+                best_level = atoi(level);
+                shared = candidate;
+            }
+        }
+        if (best_level > 0) {
+            int g;
+            for (g = 0; g < topology.ncaches && !CPU_EQUAL(&topology.caches[g], &shared); g++);
+            if (g == topology.ncaches && g < MAX_CPU_GROUPS) topology.caches[topology.ncaches++] = shared;
+        }
+
+        // cpuN 디렉토리의 nodeM 항목으로 NUMA 노드 확인
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+        DIR *dir = opendir(path);
+        struct dirent *entry;
+        int node = 0;
+        while (dir != NULL && (entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+                node = atoi(entry->d_name + 4);
+            }
+        }
+        if (dir != NULL) closedir(dir);
+        if (node < MAX_NUMA_NODES) {
+            CPU_SET(cpu, &topology.nodes[node]);
+            if (node >= topology.nnodes) topology.nnodes = node + 1;
+        }
+    }
+}
+
+void pin_command(char **argv) {
+    char list[4096];
+    if (argv[1] != NULL) {
+        if (strcmp(argv[1], "auto") == 0) {
+            auto_place = 1;
+        } else if (strcmp(argv[1], "off") == 0) {
+            auto_place = 0;
+        } else {
+            fprintf(stderr, "Usage: pin [auto|off] | pin <cpulist> <command>\n");
+        }
+        return;
+    }
+
+    // 인자 없음: 토폴로지 출력
+    load_topology();
+    format_cpulist(&topology.online, list, sizeof(list));
+    printf("online cpus: %s\n", list);
+    for (int g = 0; g < topology.ncaches; g++) {
+        format_cpulist(&topology.caches[g], list, sizeof(list));
+        printf("cache group %d: %s\n", g, list);
+    }
+    for (int n = 0; n < topology.nnodes; n++) {
+        if (CPU_COUNT(&topology.nodes[n]) == 0) continue;
+        format_cpulist(&topology.nodes[n], list, sizeof(list));
+        printf("numa node %d: %s\n", n, list);
+    }
+    printf("auto placement: %s\n", auto_place ? "on" : "off");
+}
+
+int take_pin_prefix(char **argv, cpu_set_t *set) {
+    if (strcmp(argv[0], "pin") != 0 || argv[1] == NULL || argv[2] == NULL) return 0;
+    if (parse_cpulist(argv[1], set) != 0) return 0;
+    int i = 0;
+    do { // "pin <cpulist>" 두 단어를 제거
+        argv[i] = argv[i + 2];
+    } while (argv[i++] != NULL);
+    return 1;
+}
+
+int auto_placement(int kind, cpu_set_t *set) {
+    if (!auto_place) return 0;
+    load_topology();
+    if (kind == PLACE_PIPELINE) { // 파이프로 연결된 단계들은 같은 캐시 묶음에
+        if (topology.ncaches < 2) return 0; // 묶음이 하나뿐이면 고정할 필요 없음
+        *set = topology.caches[next_cache_group++ % topology.ncaches];
+        return 1;
+    }
+    int nonempty = 0; // 독립된 작업은 NUMA 노드에 고르게
+    for (int n = 0; n < topology.nnodes; n++) nonempty += CPU_COUNT(&topology.nodes[n]) > 0;
+    if (nonempty < 2) return 0;
+    do {
+        *set = topology.nodes[next_node++ % topology.nnodes];
+    } while (CPU_COUNT(set) == 0);
+    return 1;
+}
+
+void apply_placement(const cpu_set_t *set) {
+    if (sched_setaffinity(0, sizeof(*set), set) != 0) perror("sched_setaffinity failed");
+}
+
+// on-change 감시 상태 (디렉토리 감시 캐시는 watch descriptor를 인덱스로 사용)
+struct watch_set {
+    int fd;          // inotify 디스크립터
+    char **paths;    // paths[wd] = 감시 중인 경로 (없으면 NULL)
+    int cap;
+    int count;       // 감시 중인 경로 수 (0이 되면 더 이상 바뀔 것이 없음)
+};
+
+#define WATCH_FILE_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+#define WATCH_DIR_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE \
+                          | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR)
+
+// 경로 하나에 감시 추가 (디렉토리는 하위 디렉토리까지 재귀적으로)
+static void watch_add(struct watch_set *ws, const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return;
+    }
+    int is_dir = S_ISDIR(st.st_mode);
+    int wd = inotify_add_watch(ws->fd, path, is_dir ? WATCH_DIR_EVENTS : WATCH_FILE_EVENTS);
+    if (wd < 0) {
+        perror("inotify_add_watch failed");
+        return;
+    }
+    if (wd >= ws->cap) { // 캐시 확장
+        int cap = wd * 2 + 16;
+        char **bigger = realloc(ws->paths, cap * sizeof(char *));
+        if (bigger == NULL) return;
+        memset(bigger + ws->cap, 0, (cap - ws->cap) * sizeof(char *));
+        ws->paths = bigger;
+        ws->cap = cap;
+    }
+    if (ws->paths[wd] != NULL) return; // 이미 감시 중 (같은 디렉토리를 다시 만난 경우)
+    ws->paths[wd] = strdup(path);
+    ws->count++;
+    if (!is_dir) return;
+
+    DIR *dir = opendir(path);
+    if (dir == NULL) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) { // 하위 디렉토리 감시 추가
+        if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) continue;
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        char child[PATH_MAX];
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        if (entry->d_type == DT_UNKNOWN && (stat(child, &st) != 0 || !S_ISDIR(st.st_mode))) continue;
+        watch_add(ws, child);
+    }
+    closedir(dir);
+}
+
+// 상위 디렉토리를 감시 중인지 확인 (하위 디렉토리는 상위가 항상 감시되므로, 아니면 사용자가 지정한 경로)
+static int watch_has_parent(const struct watch_set *ws, const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (slash == NULL) return 0;
+    size_t len = slash - path;
+    for (int wd = 0; wd < ws->cap; wd++) {
+        if (ws->paths[wd] != NULL && strlen(ws->paths[wd]) == len && strncmp(ws->paths[wd], path, len) == 0) return 1;
+    }
+    return 0;
+}
+
+// 쌓인 inotify 이벤트를 읽어 감시 캐시를 갱신하고, 변경이 있었으면 1 반환
+static int watch_read(struct watch_set *ws) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = 0;
+    ssize_t len;
+    while ((len = read(ws->fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            const char *base = ev->wd < ws->cap ? ws->paths[ev->wd] : NULL;
+            if (base == NULL) continue;
+
+            if (ev->mask & IN_IGNORED) { // 감시 해제됨 (삭제 등): 캐시에서 제거
+                char *path = ws->paths[ev->wd];
+                ws->paths[ev->wd] = NULL;
+                ws->count--;
+                if (access(path, F_OK) == 0) watch_add(ws, path); // 파일이 교체된 경우 다시 감시
+                else if (!watch_has_parent(ws, path)) fprintf(stderr, "on-change: %s was removed, no longer watched\n", path);
+                free(path);
+                changed = 1;
+                continue;
+            }
+            if (ev->mask & IN_MOVE_SELF) { // 감시 중인 파일이 다른 이름으로 옮겨짐: 원래 경로를 다시 감시하도록 해제
+                inotify_rm_watch(ws->fd, ev->wd);
+            }
+            if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO)) && ev->len > 0) {
+                char child[PATH_MAX]; // 새로 생긴 하위 디렉토리도 감시
+                snprintf(child, sizeof(child), "%s/%s", base, ev->name);
+                watch_add(ws, child);
+            }
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// 명령어를 자식 프로세스 그룹에서 일반 실행 경로(run_command_line)로 실행
+static pid_t on_change_start(const char *command, const sigset_t *saved_mask) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        char copy[MAX_LINE];
+        setpgid(0, 0); // 취소할 때 파이프라인 전체를 한 번에 종료하기 위한 프로세스 그룹
+        sigprocmask(SIG_SETMASK, saved_mask, NULL);
+        snprintf(copy, sizeof(copy), "%s", command);
+        int status = run_command_line(copy);
+        fflush(stdout);
+        exit(status == EXIT_REQUEST ? 0 : status);
+    } else if (pid < 0) {
+        perror("fork failed");
+        return 0;
+    }
+    setpgid(pid, pid);
+    return pid;
+}
+
+// 실행 중인 명령어 취소 (프로세스 그룹에 SIGTERM)
+static void on_change_cancel(pid_t pid) {
+    kill(-pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+}
+
+// on-change [-q] [-d ms] <paths...> -- <command>
+// 변경 이벤트가 debounce 시간 동안 멈추면 명령어를 다시 실행. 실행 중이면 취소 후 재시작 (-q: 끝난 뒤 실행)
+// 이벤트가 없을 때는 poll에서 대기하므로 CPU를 사용하지 않으며, Ctrl-C로 감시 종료
+int on_change(char *line) {
+    // "--" 뒤의 명령어는 원문 그대로 보관 (실행할 때마다 치환과 파이프를 다시 처리)
+    char *command = NULL;
+    for (char *p = strstr(line, "--"); p != NULL; p = strstr(p + 2, "--")) {
+        if ((p[-1] == ' ' || p[-1] == '\t') && (p[2] == ' ' || p[2] == '\t' || p[2] == '\0')) {
+            *p = '\0';
+            command = p + 2 + strspn(p + 2, " \t");
+            break;
+        }
+    }
+    char *argv[MAX_ARGS];
+    int narg = getargs(line, argv);
+    int queue = 0;
+    long debounce = ON_CHANGE_DEBOUNCE_MS;
+    int i = 1;
+    for (; i < narg && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            queue = 1;
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < narg) {
+            char *end;
+            debounce = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || debounce < 0) {
+                fprintf(stderr, "on-change: invalid debounce '%s' (milliseconds)\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else {
+            break;
+        }
+    }
+    if (command == NULL || *command == '\0' || i == narg) {
+        fprintf(stderr, "Usage: on-change [-q] [-d ms] <paths...> -- <command>\n");
+        return EXIT_FAILURE;
+    }
+
+    struct watch_set ws = { inotify_init1(IN_NONBLOCK | IN_CLOEXEC), NULL, 0, 0 };
+    if (ws.fd < 0) {
+        perror("inotify_init1 failed");
+        return EXIT_FAILURE;
+    }
+    for (; i < narg; i++) watch_add(&ws, argv[i]);
+    if (ws.count == 0) { // 감시할 수 있는 경로가 없음
+        free(ws.paths);
+        close(ws.fd);
+        return EXIT_FAILURE;
+    }
+
+    // SIGINT(감시 종료)와 SIGCHLD(명령어 종료)는 signalfd로 받음
+    sigset_t mask, saved_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, &saved_mask);
+    int sig_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    pid_t running = on_change_start(command, &saved_mask); // 처음 한 번 실행
+    int pending = 0;          // debounce 대기 중인 변경이 있는지
+    int queued = 0;           // -q: 실행 중에 들어온 변경
+    long long deadline = 0;   // debounce가 끝나는 시각
+    int stop = sig_fd < 0;
+    int result = 0;
+
+    while (!stop) {
+        struct pollfd fds[2] = { { ws.fd, POLLIN, 0 }, { sig_fd, POLLIN, 0 } };
+        long long timeout = pending ? deadline - now_ms() : -1;
+        if (poll(fds, 2, timeout < 0 && pending ? 0 : (int)timeout) < 0 && errno != EINTR) break;
+
+        if (fds[0].revents & POLLIN && watch_read(&ws)) { // 변경 발생: debounce 시각 갱신
+            pending = 1;
+            deadline = now_ms() + debounce;
+        }
+        if (ws.count == 0) { // 감시하던 경로가 모두 삭제됨: 더 기다려도 이벤트가 오지 않음
+            fprintf(stderr, "on-change: all watched paths were removed, stopping\n");
+            stop = 1;
+            result = EXIT_FAILURE;
+        }
+        if (fds[1].revents & POLLIN) {
+            struct signalfd_siginfo info;
+            while (read(sig_fd, &info, sizeof(info)) == sizeof(info)) {
+                if (info.ssi_signo == SIGINT) stop = 1;
+            }
+            if (running > 0 && waitpid(running, NULL, WNOHANG) == running) { // 명령어 종료
+                running = 0;
+                if (queued) {
+                    queued = 0;
+                    running = on_change_start(command, &saved_mask);
+                }
+            }
+        }
+        if (!stop && pending && now_ms() >= deadline) { // 변경이 잠잠해짐: 다시 실행
+            pending = 0;
+            if (running > 0 && queue) {
+                queued = 1;
+            } else {
+                if (running > 0) on_change_cancel(running);
+                running = on_change_start(command, &saved_mask);
+            }
+        }
+    }
+
+    if (running > 0) on_change_cancel(running);
+    close(sig_fd);
+    sigprocmask(SIG_SETMASK, &saved_mask, NULL);
+    for (int wd = 0; wd < ws.cap; wd++) free(ws.paths[wd]);
+    free(ws.paths);
+    close(ws.fd);
+    return result;
+}
+
+static struct pipe_stat pipestat_last[MAX_ARGS];   // 마지막으로 계측한 파이프라인의 결과
+static char pipestat_names[MAX_ARGS][32];          // 마지막 파이프라인의 단계 이름
+static int pipestat_last_links = 0;
+static double pipestat_last_seconds = 0;
+
+// 중계 프로세스: 앞 단계 파이프에서 뒤 단계 파이프로 옮기며 계측
+// 바이트 모드는 splice로 커널 안에서 옮기고, 줄 모드는 tee로 넘긴 뒤 같은 양을 읽어 개행을 셈
+static void pipestat_relay(int in, int out, struct pipe_stat *st) {
+    static char scratch[1 << 16];
+    int lines = pipestat_mode == PIPESTAT_LINES;
+    __atomic_store_n(&st->capacity, fcntl(out, F_GETPIPE_SZ), __ATOMIC_RELAXED);
+
+    while (1) {
+        int fill;
+        if (ioctl(in, FIONREAD, &fill) == 0) __atomic_store_n(&st->up_fill, fill, __ATOMIC_RELAXED);
+        if (ioctl(out, FIONREAD, &fill) == 0) __atomic_store_n(&st->down_fill, fill, __ATOMIC_RELAXED);
+
+        ssize_t n = lines ? tee(in, out, sizeof(scratch), SPLICE_F_NONBLOCK)
+                          : splice(in, NULL, out, NULL, sizeof(scratch), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            if (lines) { // tee로 넘긴 만큼 입력에서 읽어 버리면서 개행 계산
+                ssize_t got = read(in, scratch, n);
+                uint64_t count = 0;
+                for (char *p = scratch; got > 0 && (p = memchr(p, '\n', scratch + got - p)) != NULL; p++) count++;
+                __atomic_fetch_add(&st->lines, count, __ATOMIC_RELAXED);
+            }
+            __atomic_fetch_add(&st->bytes, n, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (n == 0) break; // 앞 단계 종료
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) break; // 뒤 단계 종료 (EPIPE) 등
+
+        // 입력에 데이터가 있으면 출력 파이프가 가득 찬 것 (뒤 단계가 느림), 없으면 입력 대기
+        struct pollfd pfd = { in, POLLIN, 0 };
+        if (ioctl(in, FIONREAD, &fill) == 0 && fill > 0) pfd = (struct pollfd){ out, POLLOUT, 0 };
+        poll(&pfd, 1, PIPESTAT_TICK_MS);
+    }
+}
+
+int pipestat_insert_relay(int up_read, struct pipe_stat *st, pid_t *relay) {
+    int down[2];
+    *relay = 0;
+    if (pipe(down) == -1) { // 실패하면 중계 없이 그대로 연결
+        perror("pipe failed");
+        return up_read;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGQUIT, SIG_DFL);
+        signal(SIGTSTP, SIG_DFL);
+        close(down[0]);
+        pipestat_relay(up_read, down[1], st);
+        exit(0);
+    } else if (pid < 0) {
+        perror("fork failed");
+        close(down[0]);
+        close(down[1]);
+        return up_read;
+    }
+    close(up_read);
+    close(down[1]);
+    *relay = pid;
+    return down[0];
+}
+
+// 파이프 상태: 뒤쪽 파이프가 가득 차면 blocked (뒤 단계가 병목), 양쪽이 비어 있으면 starved (앞 단계가 병목)
+static const char *pipestat_state(const struct pipe_stat *st) {
+    int capacity = __atomic_load_n(&st->capacity, __ATOMIC_RELAXED);
+    int down = __atomic_load_n(&st->down_fill, __ATOMIC_RELAXED);
+    int up = __atomic_load_n(&st->up_fill, __ATOMIC_RELAXED);
+    if (capacity > 0 && down >= capacity - 4096) return "blocked";
+    if (up == 0 && down == 0) return "starved";
+    return "flowing";
+}
+
+// 단계 이름 (명령어의 첫 단어, "|| N [-u] cmd" 단계는 cmd 앞에 "||"를 붙임)
+static void pipestat_stage_name(const char *command, int sharded, char *name, size_t size) {
+    command += strspn(command, " \t");
+    if (sharded) { // 작업자 수와 -u 옵션 건너뛰기
+        command += strcspn(command, " \t");
+        command += strspn(command, " \t");
+        if (strncmp(command, "-u", 2) == 0 && (command[2] == ' ' || command[2] == '\t')) {
+            command += 2 + strspn(command + 2, " \t");
+        }
+    }
+    snprintf(name, size, "%s%.*s", sharded ? "||" : "", (int)strcspn(command, " \t"), command);
+}
+
+void pipestat_monitor(struct pipe_stat *stats, char **commands, int *sharded, pid_t *pids, int npids, int *status) {
+    int nlinks = npids - 1;
+    int live = isatty(STDERR_FILENO); // 터미널이면 상태 줄을 계속 갱신
+    uint64_t last_bytes[MAX_ARGS] = { 0 }, last_lines[MAX_ARGS] = { 0 };
+    long long start = now_ms(), last_draw = start;
+    int remaining = npids;
+
+    while (remaining > 0) {
+        for (int i = 0; i < npids; i++) { // 끝난 단계 회수
+            if (pids[i] > 0 && waitpid(pids[i], i == npids - 1 ? status : NULL, WNOHANG) == pids[i]) {
+                pids[i] = 0;
+                remaining--;
+            }
+        }
+        if (remaining == 0) break;
+
+        for (int i = 0; i < nlinks; i++) { // 파이프 상태 샘플링
+            const char *state = pipestat_state(&stats[i]);
+            stats[i].samples++;
+            if (strcmp(state, "blocked") == 0) stats[i].blocked++;
+            else if (strcmp(state, "starved") == 0) stats[i].starved++;
+        }
+
+        long long now = now_ms();
+        if (live && now - last_draw >= PIPESTAT_DRAW_MS) { // 구간 처리량과 현재 상태 표시
+            double seconds = (now - last_draw) / 1000.0;
+            fprintf(stderr, "\r\033[K");
+            for (int i = 0; i < nlinks; i++) {
+                uint64_t bytes = __atomic_load_n(&stats[i].bytes, __ATOMIC_RELAXED);
+                uint64_t lines = __atomic_load_n(&stats[i].lines, __ATOMIC_RELAXED);
+                fprintf(stderr, "%s[%d] %.1f MB/s", i ? " | " : "", i + 1, (bytes - last_bytes[i]) / seconds / 1e6);
+                if (pipestat_mode == PIPESTAT_LINES) {
+                    fprintf(stderr, " %.1fk lines/s", (lines - last_lines[i]) / seconds / 1e3);
+                }
+                fprintf(stderr, " %s", pipestat_state(&stats[i]));
+                last_bytes[i] = bytes;
+                last_lines[i] = lines;
+            }
+            last_draw = now;
+        }
+        poll(NULL, 0, PIPESTAT_TICK_MS);
+    }
+    if (live && last_draw != start) fprintf(stderr, "\r\033[K"); // 상태 줄 지우기
+
+    // pipestat 명령어로 볼 수 있도록 결과 보관
+    pipestat_last_links = nlinks;
+    pipestat_last_seconds = (now_ms() - start) / 1000.0;
+    for (int i = 0; i < npids; i++) {
+        pipestat_stage_name(commands[i], sharded[i], pipestat_names[i], sizeof(pipestat_names[i]));
+        if (i < nlinks) pipestat_last[i] = stats[i];
+    }
+}
+
+void pipestat_command(char **argv) {
+    if (argv[1] != NULL) {
+        if (strcmp(argv[1], "on") == 0) {
+            pipestat_mode = argv[2] != NULL && strcmp(argv[2], "-l") == 0 ? PIPESTAT_LINES : PIPESTAT_BYTES;
+        } else if (strcmp(argv[1], "off") == 0) {
+            pipestat_mode = PIPESTAT_OFF;
+        } else {
+            fprintf(stderr, "Usage: pipestat [on [-l] | off]\n");
+        }
+        return;
+    }
+
+    // 인자 없음: 마지막으로 계측한 파이프라인 결과 출력
+    if (pipestat_last_links == 0) {
+        printf("pipestat: %s, no pipeline measured yet\n", pipestat_mode == PIPESTAT_OFF ? "off" : "on");
+        return;
+    }
+    double seconds = pipestat_last_seconds > 0 ? pipestat_last_seconds : 1e-3;
+    for (int i = 0; i < pipestat_last_links; i++) {
+        struct pipe_stat *st = &pipestat_last[i];
+        int samples = st->samples > 0 ? st->samples : 1;
+        printf("[%d] %s -> %s: %llu bytes (%.1f MB/s)", i + 1, pipestat_names[i], pipestat_names[i + 1],
+               (unsigned long long)st->bytes, st->bytes / seconds / 1e6);
+        if (st->lines > 0) printf(", %llu lines (%.1fk lines/s)", (unsigned long long)st->lines, st->lines / seconds / 1e3);
+        printf(", blocked %d%%, starved %d%%\n", st->blocked * 100 / samples, st->starved * 100 / samples);
+    }
+}
+
+// 서버 모드의 클라이언트 세션 (연결마다 독립된 작업 디렉토리, 변수, 작업 테이블)
+struct session {
+    int fd;                           // 클라이언트 연결 소켓
+    char cwd[PATH_MAX];               // 세션별 작업 디렉토리
+    char vars[MAX_VARS][MAX_LINE];    // 세션별 변수 (NAME=value 형식)
+    int nvars;
+    pid_t jobs[MAX_JOBS];             // 세션별 백그라운드 작업 테이블
+    int njobs;
+    pid_t fg_pid;                     // 실행 중인 포그라운드 명령 (없으면 0)
+};
+
+static struct session *sessions[MAX_SESSIONS]; // 세션 테이블 (인덱스 = epoll 태그)
+static int serve_epfd = -1;                    // 서버 모드의 epoll 디스크립터
+
+#define TAG_LISTEN ((uint64_t)-1) // epoll 태그: 리스닝 소켓
+#define TAG_SIGNAL ((uint64_t)-2) // epoll 태그: SIGCHLD signalfd
+
+#define FRAME_REPLY 'R'   // 프레임 종류: 상태 응답 ("exit <status>", "job <pid>", "error <errno>")
+#define FRAME_OUTPUT 'O'  // 프레임 종류: 명령 출력 (stdout을 전달받지 않은 경우)
+#define FRAME_MAX 4096    // 프레임 최대 크기 (종류 바이트 포함)
+
+// 세션 소켓으로 프레임 하나 전송 (첫 바이트가 프레임 종류, len은 FRAME_MAX - 1 이하)
+static int send_frame(int fd, char type, const char *data, size_t len) {
+    char frame[FRAME_MAX];
+    frame[0] = type;
+    memcpy(frame + 1, data, len);
+    return send(fd, frame, len + 1, MSG_NOSIGNAL);
+}
+
+// 세션 소켓으로 응답 프레임 전송
+static void send_reply(struct session *s, const char *fmt, int value) {
+    char msg[64];
+    int len = snprintf(msg, sizeof(msg), fmt, value);
+    send_frame(s->fd, FRAME_REPLY, msg, len);
+}
+
+// 세션 소켓의 읽기 이벤트 활성/비활성 (명령 실행 중에는 다음 요청을 읽지 않음)
+static void session_set_readable(int idx, int on) {
+    struct epoll_event ev = { .events = on ? EPOLLIN : 0, .data.u64 = idx };
+    epoll_ctl(serve_epfd, EPOLL_CTL_MOD, sessions[idx]->fd, &ev);
+}
+
+// 세션 종료: 소켓을 닫고 실행 중인 포그라운드 명령과 백그라운드 작업의 프로세스 그룹에 SIGHUP 전달
+static void session_close(int idx) {
+    struct session *s = sessions[idx];
+    if (s->fg_pid > 0) kill(-s->fg_pid, SIGHUP);
+    for (int i = 0; i < s->njobs; i++) kill(-s->jobs[i], SIGHUP);
+    epoll_ctl(serve_epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    free(s);
+    sessions[idx] = NULL;
+}
+
+// 세션 상태를 바꾸는 명령어 처리 (cd, 변수 대입, jobs). 처리했으면 0 반환
+static int session_builtin(struct session *s, char *line) {
+    char copy[MAX_LINE];
+    char *argv[MAX_ARGS];
+    strcpy(copy, line);
+    if (getargs(copy, argv) == 0) {
+        send_reply(s, "exit %d\n", 0);
+        return 0;
+    }
+
+    // cd: 서버 프로세스의 디렉토리가 아니라 세션의 디렉토리를 변경
+    if (strcmp(argv[0], "cd") == 0) {
+        int ok = argv[1] != NULL && chdir(s->cwd) == 0 && chdir(argv[1]) == 0
+                 && getcwd(s->cwd, sizeof(s->cwd)) != NULL;
+        if (chdir("/") == -1) perror("chdir failed");
+        send_reply(s, "exit %d\n", ok ? 0 : 1);
+        return 0;
+    }
+
+    // jobs: 세션의 백그라운드 작업 목록 출력
+    if (strcmp(argv[0], "jobs") == 0) {
+        for (int i = 0; i < s->njobs; i++) {
+            char msg[64];
+            int len = snprintf(msg, sizeof(msg), "[%d] %d\n", i + 1, s->jobs[i]);
+            send_frame(s->fd, FRAME_OUTPUT, msg, len);
+        }
+        send_reply(s, "exit %d\n", 0);
+        return 0;
+    }
+
+    // NAME=value: 세션 변수 설정 (이후 명령의 환경 변수로 전달)
+    char *eq = strchr(argv[0], '=');
+    if (argv[1] == NULL && eq != NULL && eq != argv[0]) {
+        size_t name_len = eq - argv[0] + 1;
+        int i;
+        for (i = 0; i < s->nvars; i++) {
+            if (strncmp(s->vars[i], argv[0], name_len) == 0) break; // 같은 이름 덮어쓰기
+        }
+        if (i == MAX_VARS) {
+            send_reply(s, "error %d\n", ENOSPC);
+            return 0;
+        }
+        if (i == s->nvars) s->nvars++;
+        snprintf(s->vars[i], MAX_LINE, "%s", argv[0]);
+        send_reply(s, "exit %d\n", 0);
+        return 0;
+    }
+
+    return 1; // 세션 명령어가 아님
+}
+
+// 세션 명령 실행: 자식 프로세스에서 세션 상태를 적용한 뒤 run_command_line 호출
+static void session_run(int idx, char *line, int *fds, int nfds) {
+    struct session *s = sessions[idx];
+
+    // 끝의 '&'는 서버에서 처리하여 세션 작업 테이블에 등록
+    int background = 0;
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t')) line[--len] = '\0';
+    if (len > 0 && line[len - 1] == '&') {
+        if (s->njobs == MAX_JOBS) {
+            send_reply(s, "error %d\n", EAGAIN);
+            return;
+        }
+        background = 1;
+        line[--len] = '\0';
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) { // 자식 프로세스
+        setpgid(0, 0); // 세션 종료 시 명령 전체에 SIGHUP을 보낼 수 있도록 새 프로세스 그룹
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, NULL); // 서버에서 막아둔 SIGCHLD 복구
+        signal(SIGPIPE, SIG_DFL);
+        for (int i = 0; i < MAX_SESSIONS; i++) { // 다른 세션의 연결은 닫기
+            if (sessions[i] != NULL && i != idx) close(sessions[i]->fd);
+        }
+
+        // 전달받은 디스크립터 연결: 순서대로 stdin, stdout, stderr
+        // 없으면 stdin은 /dev/null, stdout/stderr는 파이프로 받아 출력 프레임으로 중계
+        int relay[2] = { -1, -1 };
+        int in = nfds > 0 ? fds[0] : open("/dev/null", O_RDONLY);
+        int out = nfds > 1 ? fds[1] : -1;
+        if (out == -1) {
+            if (pipe(relay) == -1) {
+                perror("pipe failed");
+                exit(EXIT_FAILURE);
+            }
+            out = relay[1];
+        }
+        int err = nfds > 2 ? fds[2] : out;
+        dup2(in, STDIN_FILENO);
+        dup2(out, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+
+        if (chdir(s->cwd) == -1) {
+            perror("chdir failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < s->nvars; i++) {
+            char *eq = strchr(s->vars[i], '=');
+            *eq = '\0';
+            setenv(s->vars[i], eq + 1, 1);
+        }
+
+        // 중계가 필요하면 명령은 손자 프로세스에서 실행하고, 이 프로세스는 출력을 프레임으로 전송
+        pid_t cmd = relay[0] != -1 ? fork() : 0;
+        if (cmd == 0) {
+            if (relay[0] != -1) {
+                close(relay[0]);
+                close(relay[1]);
+            }
+            close(s->fd);
+            int status = run_command_line(line);
+            fflush(stdout);
+            exit(status == EXIT_REQUEST ? 0 : status);
+        } else if (cmd < 0) {
+            perror("fork failed");
+            exit(EXIT_FAILURE);
+        }
+
+        close(relay[1]); // 명령 쪽 쓰기 끝만 남겨 종료 시 EOF를 받도록
+        close(STDOUT_FILENO);
+        if (err == out) close(STDERR_FILENO);
+        char data[FRAME_MAX - 1];
+        ssize_t n;
+        while ((n = read(relay[0], data, sizeof(data))) != 0) {
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 || send_frame(s->fd, FRAME_OUTPUT, data, n) < 0) break; // 연결이 끊기면 중계 중단
+        }
+        close(relay[0]);
+        int status;
+        while (waitpid(cmd, &status, 0) < 0 && errno == EINTR);
+        exit(WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status));
+    } else if (pid < 0) {
+        perror("fork failed");
+        send_reply(s, "error %d\n", errno);
+        return;
+    }
+    setpgid(pid, pid); // 자식과 경쟁하지 않도록 부모에서도 설정
+
+    if (background) { // 백그라운드: 즉시 작업 번호를 응답
+        s->jobs[s->njobs++] = pid;
+        send_reply(s, "job %d\n", pid);
+    } else { // 포그라운드: 종료할 때까지 다음 요청을 읽지 않음
+        s->fg_pid = pid;
+        session_set_readable(idx, 0);
+    }
+}
+
+// 세션 소켓에서 요청 하나를 읽어 처리 (SCM_RIGHTS로 전달된 디스크립터 포함)
+static void session_request(int idx) {
+    struct session *s = sessions[idx];
+    char line[MAX_LINE];
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } control;
+    struct iovec iov = { .iov_base = line, .iov_len = sizeof(line) - 1 };
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control.buf, .msg_controllen = sizeof(control.buf),
+    };
+
+    ssize_t n = recvmsg(s->fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n <= 0) { // 연결 종료 또는 오류
+        session_close(idx);
+        return;
+    }
+    line[n] = '\0';
+    if (n > 0 && line[n - 1] == '\n') line[--n] = '\0'; // 끝의 개행 문자 제거
+
+    int fds[3];
+    int nfds = 0;
+    int extra_fds = 0; // 3개를 넘어 받은 디스크립터 (받는 즉시 닫음)
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c != NULL; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+            int count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (int i = 0; i < count; i++) {
+                int fd;
+                memcpy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+                if (nfds < 3) {
+                    fds[nfds++] = fd;
+                } else {
+                    close(fd);
+                    extra_fds = 1;
+                }
+            }
+        }
+    }
+
+    // 잘린 요청 (줄이 MAX_LINE보다 길거나 디스크립터가 3개보다 많음)이나 여러 줄 요청은
+    // 일부만 실행하면 다른 명령이 되므로 실행하지 않고 거절
+    if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) || extra_fds) {
+        for (int i = 0; i < nfds; i++) close(fds[i]);
+        send_reply(s, "error %d\n", EMSGSIZE);
+        return;
+    }
+    if (memchr(line, '\n', n) != NULL || memchr(line, '\0', n) != NULL) {
+        for (int i = 0; i < nfds; i++) close(fds[i]);
+        send_reply(s, "error %d\n", EINVAL);
+        return;
+    }
+
+    if (strcmp(line, "exit") == 0) { // exit: 세션만 종료
+        for (int i = 0; i < nfds; i++) close(fds[i]);
+        session_close(idx);
+        return;
+    }
+
+    if (session_builtin(s, line) != 0) {
+        session_run(idx, line, fds, nfds);
+    }
+    for (int i = 0; i < nfds; i++) close(fds[i]); // 자식에게 넘겨준 뒤 서버 쪽 사본은 닫기
+}
+
+// 종료된 자식 프로세스를 회수하고 해당 세션에 종료 상태 응답
+static void reap_children(void) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        int code = WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+        for (int idx = 0; idx < MAX_SESSIONS; idx++) {
+            struct session *s = sessions[idx];
+            if (s == NULL) continue;
+            if (s->fg_pid == pid) { // 포그라운드 명령 종료: 결과 전송 후 다음 요청 허용
+                s->fg_pid = 0;
+                send_reply(s, "exit %d\n", code);
+                session_set_readable(idx, 1);
+                break;
+            }
+            int j;
+            for (j = 0; j < s->njobs && s->jobs[j] != pid; j++);
+            if (j < s->njobs) { // 백그라운드 작업 종료: 작업 테이블에서 제거
+                s->jobs[j] = s->jobs[--s->njobs];
+                break;
+            }
+        }
+    }
+}
+
+// 유닉스 소켓 서버 모드: 하나의 프로세스가 epoll로 여러 클라이언트 세션을 처리
+// 요청 한 패킷 = 명령어 한 줄. 서버가 보내는 패킷은 첫 바이트로 종류를 구분:
+// 'R' + "exit <status>\n" 등의 상태 응답, 'O' + 명령 출력 (stdout을 전달하지 않은 경우, FRAME_MAX 단위)
+int serve(const char *sock_path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "serve: socket path too long\n");
+        return EXIT_FAILURE;
+    }
+    strcpy(addr.sun_path, sock_path);
+
+    // 메시지 경계가 유지되는 SOCK_SEQPACKET 사용
+    int listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        perror("socket failed");
+        return EXIT_FAILURE;
+    }
+    unlink(sock_path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(listen_fd, SOMAXCONN) == -1) {
+        perror("bind failed");
+        return EXIT_FAILURE;
+    }
+
+    // SIGCHLD는 signalfd로 받아 이벤트 루프에서 처리
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    int sig_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    signal(SIGPIPE, SIG_IGN);
+
+    serve_epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (sig_fd < 0 || serve_epfd < 0) {
+        perror("epoll setup failed");
+        return EXIT_FAILURE;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = TAG_LISTEN };
+    epoll_ctl(serve_epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.u64 = TAG_SIGNAL;
+    epoll_ctl(serve_epfd, EPOLL_CTL_ADD, sig_fd, &ev);
+
+    // 세션의 상대 경로 기준은 서버 시작 디렉토리
+    char start_cwd[PATH_MAX];
+    if (getcwd(start_cwd, sizeof(start_cwd)) == NULL) {
+        perror("getcwd failed");
+        return EXIT_FAILURE;
+    }
+    if (chdir("/") == -1) {
+        perror("chdir failed");
+        return EXIT_FAILURE;
+    }
+
+    struct epoll_event events[64];
+    while (1) {
+        int n = epoll_wait(serve_epfd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == TAG_LISTEN) { // 새 연결 수락
+                int fd;
+                while ((fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+                    int idx;
+                    for (idx = 0; idx < MAX_SESSIONS && sessions[idx] != NULL; idx++);
+                    struct session *s = idx < MAX_SESSIONS ? calloc(1, sizeof(*s)) : NULL;
+                    if (s == NULL) { // 세션 테이블이 가득 찬 경우 거절
+                        close(fd);
+                        continue;
+                    }
+                    s->fd = fd;
+                    strcpy(s->cwd, start_cwd);
+                    sessions[idx] = s;
+                    struct epoll_event cev = { .events = EPOLLIN, .data.u64 = idx };
+                    epoll_ctl(serve_epfd, EPOLL_CTL_ADD, fd, &cev);
+                }
+            } else if (tag == TAG_SIGNAL) { // 자식 프로세스 종료
+                struct signalfd_siginfo info;
+                while (read(sig_fd, &info, sizeof(info)) > 0);
+                reap_children();
+            } else if (sessions[tag] != NULL) { // 클라이언트 요청 또는 연결 종료
+                if (events[i].events & EPOLLIN) {
+                    session_request(tag);
+                } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    session_close(tag);
+                }
+            }
+        }
+    }
+}
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -5,11 +6,39 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 
 #define MAX_LINE 256 // 최대 입력 줄 길이
 #define MAX_ARGS 50  // 최대 명령어 인자 수
 
+#define PIPESTAT_OFF 0         // pipestat 계측 꺼짐
+#define PIPESTAT_BYTES 1       // 바이트만 계측 (splice, 데이터 복사 없음)
+#define PIPESTAT_LINES 2       // 줄 수도 계측 (tee 후 읽어서 개행 계산)
+#define PIPESTAT_TICK_MS 50    // 파이프 상태 샘플링 주기
+#define PIPESTAT_DRAW_MS 500   // 상태 줄 갱신 주기
+
+// 파이프 계측값 (중계 프로세스와 쉘이 공유 메모리로 공유)
+struct pipe_stat {
+    uint64_t bytes, lines;   // 중계한 바이트/줄 수 (중계 프로세스가 갱신)
+    int up_fill, down_fill;  // 앞 명령어 쪽/뒤 명령어 쪽 파이프에 쌓인 바이트 (FIONREAD)
+    int capacity;            // 파이프 용량 (F_GETPIPE_SZ)
+    int blocked, starved, samples; // 쉘이 샘플링한 상태 횟수
+    double seconds;          // 파이프라인 실행 시간
+};
+
 int getargs(char *cmd, char **argv);
+void pipestat_command(char **argv); // pipestat 내장 명령어 (계측 켜기/끄기, 마지막 결과 출력)
+int pipestat_insert_relay(int up_read, pid_t *relay); // 파이프 사이에 계측용 중계 프로세스 삽입
+void pipestat_monitor(pid_t pid1, pid_t pid2); // 파이프라인 종료 대기 중 상태 표시
+
+static int pipestat_mode = PIPESTAT_OFF;   // pipestat 계측 모드
+static struct pipe_stat *pipestat = NULL; // 공유 계측값 (처음 켤 때 매핑)
+static int pipestat_measured = 0;         // 계측한 파이프라인이 있는지
 
 int main() {
     char buf[MAX_LINE]; // 입력 저장 버퍼
@@ -35,6 +64,10 @@ int main() {
         if (!is_pipe) { // 단일 명령어 처리
             int narg = getargs(commands[0], argv);
             if (strcmp(argv[0], "exit") == 0) break; // exit 처리
+            if (strcmp(argv[0], "pipestat") == 0) { // pipestat 처리
+                pipestat_command(argv);
+                continue;
+            }
 
             pid = fork();
             if (pid == 0) { // 자식 프로세스
@@ -82,11 +115,17 @@ int main() {
                 exit(EXIT_FAILURE);
             }
 
+            close(pipe_fd[1]);
+
+            // pipestat: 두 명령어 사이에 중계 프로세스를 넣어 계측
+            int in_fd = pipe_fd[0]; // 두 번째 명령어의 입력
+            pid_t relay = 0;
+            if (pipestat_mode != PIPESTAT_OFF) in_fd = pipestat_insert_relay(pipe_fd[0], &relay);
+
             pid_t pid2 = fork();
             if (pid2 == 0) { // 두 번째 명령어 실행
-                close(pipe_fd[1]);
-                dup2(pipe_fd[0], STDIN_FILENO);
-                close(pipe_fd[0]);
+                dup2(in_fd, STDIN_FILENO);
+                close(in_fd);
                 char *argv2[MAX_ARGS];
                 getargs(commands[1], argv2);
                 execvp(argv2[0], argv2);
@@ -94,10 +133,14 @@ int main() {
                 exit(EXIT_FAILURE);
             }
 
-            close(pipe_fd[0]);
-            close(pipe_fd[1]);
-            wait(NULL); // 첫 번째 명령어 종료 대기
-            wait(NULL); // 두 번째 명령어 종료 대기
+            close(in_fd);
+            if (relay > 0) { // 계측 중: 종료를 기다리며 처리량과 막힘 상태 표시
+                pipestat_monitor(pid1, pid2);
+                waitpid(relay, NULL, 0);
+            } else {
+                wait(NULL); // 첫 번째 명령어 종료 대기
+                wait(NULL); // 두 번째 명령어 종료 대기
+            }
         }
     }
     return 0;
@@ -113,4 +156,149 @@ int getargs(char *cmd, char **argv) {
     }
     argv[narg] = NULL; // 마지막 인자 NULL
     return narg;
-}
\ No newline at end of file
+}
+
+// 현재 시각 (밀리초)
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// 중계 프로세스: 앞 명령어 파이프에서 뒤 명령어 파이프로 옮기며 계측
+// 바이트 모드는 splice로 커널 안에서 옮기고, 줄 모드는 tee로 넘긴 뒤 같은 양을 읽어 개행을 셈
+static void pipestat_relay(int in, int out, struct pipe_stat *st) {
+    static char scratch[1 << 16];
+    int lines = pipestat_mode == PIPESTAT_LINES;
+    __atomic_store_n(&st->capacity, fcntl(out, F_GETPIPE_SZ), __ATOMIC_RELAXED);
+
+    while (1) {
+        int fill;
+        if (ioctl(in, FIONREAD, &fill) == 0) __atomic_store_n(&st->up_fill, fill, __ATOMIC_RELAXED);
+        if (ioctl(out, FIONREAD, &fill) == 0) __atomic_store_n(&st->down_fill, fill, __ATOMIC_RELAXED);
+
+        ssize_t n = lines ? tee(in, out, sizeof(scratch), SPLICE_F_NONBLOCK)
+                          : splice(in, NULL, out, NULL, sizeof(scratch), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            if (lines) { // tee로 넘긴 만큼 입력에서 읽어 버리면서 개행 계산
+                ssize_t got = read(in, scratch, n);
+                uint64_t count = 0;
+                for (char *p = scratch; got > 0 && (p = memchr(p, '\n', scratch + got - p)) != NULL; p++) count++;
+                __atomic_fetch_add(&st->lines, count, __ATOMIC_RELAXED);
+            }
+            __atomic_fetch_add(&st->bytes, n, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (n == 0) break; // 앞 명령어 종료
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) break; // 뒤 명령어 종료 (EPIPE) 등
+
+        // 입력에 데이터가 있으면 출력 파이프가 가득 찬 것 (뒤 명령어가 느림), 없으면 입력 대기
+        struct pollfd pfd = { in, POLLIN, 0 };
+        if (ioctl(in, FIONREAD, &fill) == 0 && fill > 0) pfd = (struct pollfd){ out, POLLOUT, 0 };
+        poll(&pfd, 1, PIPESTAT_TICK_MS);
+    }
+}
+
+int pipestat_insert_relay(int up_read, pid_t *relay) {
+    int down[2];
+    *relay = 0;
+    if (pipe(down) == -1) { // 실패하면 중계 없이 그대로 연결
+        perror("pipe failed");
+        return up_read;
+    }
+    memset(pipestat, 0, sizeof(*pipestat));
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(down[0]);
+        pipestat_relay(up_read, down[1], pipestat);
+        exit(0);
+    } else if (pid < 0) {
+        perror("fork failed");
+        close(down[0]);
+        close(down[1]);
+        return up_read;
+    }
+    close(up_read);
+    close(down[1]);
+    *relay = pid;
+    return down[0];
+}
+
+// 파이프 상태: 뒤쪽 파이프가 가득 차면 blocked (뒤 명령어가 병목), 양쪽이 비어 있으면 starved (앞 명령어가 병목)
+static const char *pipestat_state(const struct pipe_stat *st) {
+    int capacity = __atomic_load_n(&st->capacity, __ATOMIC_RELAXED);
+    int down = __atomic_load_n(&st->down_fill, __ATOMIC_RELAXED);
+    int up = __atomic_load_n(&st->up_fill, __ATOMIC_RELAXED);
+    if (capacity > 0 && down >= capacity - 4096) return "blocked";
+    if (up == 0 && down == 0) return "starved";
+    return "flowing";
+}
+
+void pipestat_monitor(pid_t pid1, pid_t pid2) {
+    int live = isatty(STDERR_FILENO); // 터미널이면 상태 줄을 계속 갱신
+    uint64_t last_bytes = 0, last_lines = 0;
+    long long start = now_ms(), last_draw = start;
+
+    while (pid1 > 0 || pid2 > 0) {
+        if (pid1 > 0 && waitpid(pid1, NULL, WNOHANG) == pid1) pid1 = 0; // 끝난 명령어 회수
+        if (pid2 > 0 && waitpid(pid2, NULL, WNOHANG) == pid2) pid2 = 0;
+        if (pid1 == 0 && pid2 == 0) break;
+
+        const char *state = pipestat_state(pipestat); // 파이프 상태 샘플링
+        pipestat->samples++;
+        if (strcmp(state, "blocked") == 0) pipestat->blocked++;
+        else if (strcmp(state, "starved") == 0) pipestat->starved++;
+
+        long long now = now_ms();
+        if (live && now - last_draw >= PIPESTAT_DRAW_MS) { // 구간 처리량과 현재 상태 표시
+            double seconds = (now - last_draw) / 1000.0;
+            uint64_t bytes = __atomic_load_n(&pipestat->bytes, __ATOMIC_RELAXED);
+            uint64_t lines = __atomic_load_n(&pipestat->lines, __ATOMIC_RELAXED);
+            fprintf(stderr, "\r\033[K%.1f MB/s", (bytes - last_bytes) / seconds / 1e6);
+            if (pipestat_mode == PIPESTAT_LINES) fprintf(stderr, " %.1fk lines/s", (lines - last_lines) / seconds / 1e3);
+            fprintf(stderr, " %s", state);
+            last_bytes = bytes;
+            last_lines = lines;
+            last_draw = now;
+        }
+        poll(NULL, 0, PIPESTAT_TICK_MS);
+    }
+    if (live && last_draw != start) fprintf(stderr, "\r\033[K"); // 상태 줄 지우기
+    pipestat->seconds = (now_ms() - start) / 1000.0;
+    pipestat_measured = 1;
+}
+
+void pipestat_command(char **argv) {
+    if (argv[1] != NULL) {
+        if (strcmp(argv[1], "on") == 0) {
+            if (pipestat == NULL) { // 중계 프로세스와 공유할 계측값 매핑
+                pipestat = mmap(NULL, sizeof(*pipestat), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+                if (pipestat == MAP_FAILED) {
+                    perror("mmap failed");
+                    pipestat = NULL;
+                    return;
+                }
+            }
+            pipestat_mode = argv[2] != NULL && strcmp(argv[2], "-l") == 0 ? PIPESTAT_LINES : PIPESTAT_BYTES;
+        } else if (strcmp(argv[1], "off") == 0) {
+            pipestat_mode = PIPESTAT_OFF;
+        } else {
+            fprintf(stderr, "Usage: pipestat [on [-l] | off]\n");
+        }
+        return;
+    }
+
+    // 인자 없음: 마지막으로 계측한 파이프라인 결과 출력
+    if (!pipestat_measured) {
+        printf("pipestat: %s, no pipeline measured yet\n", pipestat_mode == PIPESTAT_OFF ? "off" : "on");
+        return;
+    }
+    double seconds = pipestat->seconds > 0 ? pipestat->seconds : 1e-3;
+    int samples = pipestat->samples > 0 ? pipestat->samples : 1;
+    printf("%llu bytes (%.1f MB/s)", (unsigned long long)pipestat->bytes, pipestat->bytes / seconds / 1e6);
+    if (pipestat->lines > 0) {
+        printf(", %llu lines (%.1fk lines/s)", (unsigned long long)pipestat->lines, pipestat->lines / seconds / 1e3);
+    }
+    printf(", blocked %d%%, starved %d%%\n", pipestat->blocked * 100 / samples, pipestat->starved * 100 / samples);
+}
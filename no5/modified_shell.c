@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <sys/stat.h>    
 #include <dirent.h>       
 #include <errno.h>        
@@ -8,9 +9,21 @@
 #include <string.h>        
 #include <sys/types.h>     
 #include <sys/wait.h>
+#include <sys/mman.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #define MAX_LINE 256       // 최대 명령어 입력 길이
 #define MAX_ARGS 50        // 최대 명령어 인자 수
+#define IO_CHUNK (1 << 20) // 대용량 파일 입출력 단위 (1MiB)
+
+#define SORT_DEFAULT_BUFFER ((size_t)256 << 20) // sort 기본 메모리 한도 (-S)
+#define SORT_MAX_RUNS 64                         // 한 번에 병합하는 최대 run 수
+#define SORT_MAX_THREADS 16                      // run 생성에 쓰는 최대 스레드 수
 
 // 사용자 입력 명령어를 공백 단위로 분리
 int getargs(char *cmd, char **argv);
@@ -21,6 +34,74 @@ int handle_builtin_commands(char **argv);
 // 외부 명령어 실행 함수
 void execute_command(char **argv);
 
+// CRC32C 체크섬 계산 (crc에 이전 결과를 넘기면 이어서 계산)
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+// xxHash3 (64비트, seed 0) 해시 계산
+uint64_t xxh3_64(const void *data, size_t len);
+
+// xxHash3 스트리밍 계산 상태 (입력을 나누어 넣어도 xxh3_64와 같은 결과, 메모리 사용량 고정)
+#define XXH3_BUFFER_SIZE 256 // 240바이트 이하 입력은 한 번에 계산해야 하므로 그보다 크게
+struct xxh3_state {
+    uint64_t acc[8];                   // 누산기
+    size_t stripes;                    // 현재 1KiB 블록에서 처리한 스트라이프 수
+    uint64_t total;                    // 지금까지 넣은 바이트 수
+    uint8_t buffer[XXH3_BUFFER_SIZE];  // 아직 처리하지 않은 입력
+    size_t buffered;
+    uint8_t last[64];                  // 마지막으로 처리한 스트라이프 (끝 스트라이프가 앞 데이터에 걸칠 때 사용)
+};
+
+void xxh3_init(struct xxh3_state *st);
+void xxh3_update(struct xxh3_state *st, const void *data, size_t len);
+uint64_t xxh3_digest(struct xxh3_state *st);
+
+// 파일 복사 후 대상 파일을 다시 읽어 체크섬 검증 (cp --verify)
+void copy_verify(const char *src, const char *dest);
+
+// wc 결과 (in_word: 블록 경계에 걸친 단어를 이어서 세기 위한 상태)
+struct wc_counts {
+    uint64_t lines, words, bytes;
+    int in_word;
+};
+
+// 블록의 줄, 단어, 바이트 수를 누적
+void wc_count(struct wc_counts *c, const char *p, size_t len);
+
+// for_each_block에 넘기는 wc_count (ctx는 struct wc_counts)
+void wc_block(void *ctx, const char *p, size_t len);
+
+// 선택한 항목을 공백으로 구분해 출력 (name이 비어 있으면 이름 생략)
+void wc_print(const struct wc_counts *c, int show_lines, int show_words, int show_bytes, const char *name);
+
+// hay에서 needle이 처음 나오는 위치 반환 (없으면 NULL)
+const char *find_substring(const char *hay, size_t len, const char *needle, size_t n);
+
+// 입력을 큰 블록 단위로 읽어 fn에 전달 (일반 파일은 mmap, 그 외는 read)
+int for_each_block(int fd, int whole_lines, void (*fn)(void *, const char *, size_t), void *ctx);
+
+// grep 옵션과 진행 상태
+struct grep_state {
+    const char *pattern;
+    size_t plen;
+    int anchor_start, anchor_end; // '^', '$' 고정 위치
+    int invert, count_only, line_numbers; // -v, -c, -n
+    const char *label;    // 여러 파일 검색 시 출력 앞에 붙일 파일 이름
+    uint64_t lineno;      // 지금까지 지나온 줄 수
+    uint64_t matches;     // 출력 대상 줄 수
+};
+
+// 줄 단위로 끊긴 블록에서 패턴 검색
+void grep_block(void *ctx, const char *p, size_t len);
+
+// sort 옵션 (-n, -r, -u, -k N[,M])
+struct sort_options {
+    int numeric, reverse, unique;
+    int key_start, key_end; // 키 필드 범위 (1부터 시작, 0이면 지정 안 함)
+};
+
+// 메모리 한도 안에서 정렬 run을 만들고 k-way 병합하여 표준 출력으로 출력
+int sort_files(char **files, size_t budget, const struct sort_options *opts);
+
 int main() {
     char buf[MAX_LINE];    // 사용자 입력 버퍼
     char *argv[MAX_ARGS];  // 명령어 및 인자 배열
@@ -145,9 +226,15 @@ int handle_builtin_commands(char **argv) {
         return 0; // 처리 완료
     }
 
-    // "cp" 명령어 구현
+    // "cp" 명령어 구현 (--verify: 복사 후 체크섬 검증)
     if (strcmp(argv[0], "cp") == 0) {
-        if (argv[1] == NULL || argv[2] == NULL) {
+        if (argv[1] != NULL && strcmp(argv[1], "--verify") == 0) {
+            if (argv[2] == NULL || argv[3] == NULL) {
+                fprintf(stderr, "cp: missing operand\n");
+            } else {
+                copy_verify(argv[2], argv[3]);
+            }
+        } else if (argv[1] == NULL || argv[2] == NULL) {
             fprintf(stderr, "cp: missing operand\n");
         } else {
             int src_fd = open(argv[1], O_RDONLY);
@@ -207,6 +294,64 @@ int handle_builtin_commands(char **argv) {
         return 0;
     }
 
+    // sum 명령어 구현 (기본 CRC32C, -x 옵션 사용 시 xxHash3)
+    if (strcmp(argv[0], "sum") == 0) {
+        int use_xxh3 = 0;
+        if (argv[1] != NULL && strcmp(argv[1], "-x") == 0) {
+            use_xxh3 = 1;
+            argv++;
+        }
+        if (argv[1] == NULL) {
+            fprintf(stderr, "sum: missing operand\n");
+            return 0;
+        }
+        for (int i = 1; argv[i] != NULL; i++) {
+            int fd = open(argv[i], O_RDONLY);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0) {
+                perror("sum");
+                if (fd >= 0) close(fd);
+                continue;
+            }
+            // 크기를 믿을 수 없는 입력 (procfs처럼 크기가 0으로 보이는 파일, FIFO, 장치 등)은
+            // IO_CHUNK 단위로 읽으며 이어서 계산 (CRC32C는 이전 값을 넘기고, xxh3는 스트리밍 상태 사용)
+            if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+                char *buffer = malloc(IO_CHUNK);
+                uint32_t crc = 0;
+                struct xxh3_state xxh;
+                xxh3_init(&xxh);
+                ssize_t bytes = 0;
+                while (buffer != NULL && (bytes = read(fd, buffer, IO_CHUNK)) > 0) {
+                    if (use_xxh3) xxh3_update(&xxh, buffer, bytes);
+                    else crc = crc32c(crc, buffer, bytes);
+                }
+                if (buffer == NULL || bytes < 0) perror("sum");
+                else if (use_xxh3) printf("%016llx  %s\n", (unsigned long long)xxh3_digest(&xxh), argv[i]);
+                else printf("%08x  %s\n", crc, argv[i]);
+                free(buffer);
+                close(fd);
+                continue;
+            }
+
+            // 일반 파일은 전체를 mmap하여 한 번에 계산
+            void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                perror("sum: mmap");
+                close(fd);
+                continue;
+            }
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            if (use_xxh3) {
+                printf("%016llx  %s\n", (unsigned long long)xxh3_64(data, st.st_size), argv[i]);
+            } else {
+                printf("%08x  %s\n", crc32c(0, data, st.st_size), argv[i]);
+            }
+            munmap(data, st.st_size);
+            close(fd);
+        }
+        return 0;
+    }
+
     // cat 명령어 구현
     if (strcmp(argv[0], "cat") == 0) {
         if (argv[1] == NULL) {
@@ -228,6 +373,149 @@ int handle_builtin_commands(char **argv) {
         }
         return 0;
     }
+
+    // wc 명령어 구현 (-l 줄, -w 단어, -c 바이트, 파일이 없으면 표준 입력)
+    if (strcmp(argv[0], "wc") == 0) {
+        int show_lines = 0, show_words = 0, show_bytes = 0;
+        int i = 1;
+        for (; argv[i] != NULL && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+            for (char *opt = argv[i] + 1; *opt; opt++) {
+                if (*opt == 'l') show_lines = 1;
+                else if (*opt == 'w') show_words = 1;
+                else if (*opt == 'c') show_bytes = 1;
+                else {
+                    fprintf(stderr, "wc: invalid option -- '%c'\n", *opt);
+                    return 0;
+                }
+            }
+        }
+        if (!show_lines && !show_words && !show_bytes) show_lines = show_words = show_bytes = 1;
+
+        struct wc_counts total = { 0 };
+        int nfiles = 0;
+        for (int first = i; argv[i] != NULL || i == first; i++) {
+            const char *name = argv[i] != NULL ? argv[i] : "";
+            int fd = argv[i] != NULL ? open(name, O_RDONLY) : STDIN_FILENO;
+            if (fd < 0) {
+                perror("wc");
+                continue;
+            }
+            struct wc_counts c = { 0 };
+            if (for_each_block(fd, 0, wc_block, &c) != 0) {
+                perror("wc: read");
+            }
+            if (fd != STDIN_FILENO) close(fd);
+            wc_print(&c, show_lines, show_words, show_bytes, name);
+            total.lines += c.lines;
+            total.words += c.words;
+            total.bytes += c.bytes;
+            nfiles++;
+            if (argv[i] == NULL) break;
+        }
+        if (nfiles > 1) wc_print(&total, show_lines, show_words, show_bytes, "total");
+        return 0;
+    }
+
+    // sort 명령어 구현 (-n 숫자, -r 역순, -u 중복 제거, -k 키 필드, -S 메모리 한도)
+    if (strcmp(argv[0], "sort") == 0) {
+        struct sort_options opts = { 0 };
+        size_t budget = SORT_DEFAULT_BUFFER;
+        int i = 1;
+        for (; argv[i] != NULL && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+            for (char *opt = argv[i] + 1; *opt; opt++) {
+                if (*opt == 'n') opts.numeric = 1;
+                else if (*opt == 'r') opts.reverse = 1;
+                else if (*opt == 'u') opts.unique = 1;
+                else if (*opt == 'k' || *opt == 'S') {
+                    // 옵션 값은 붙여 쓰거나 (-k2) 다음 인자로 (-k 2)
+                    char *value = opt[1] != '\0' ? opt + 1 : argv[++i];
+                    char *end;
+                    if (value == NULL) {
+                        fprintf(stderr, "sort: option requires an argument -- '%c'\n", *opt);
+                        return 0;
+                    }
+                    if (*opt == 'k') {
+                        opts.key_start = strtol(value, &end, 10);
+                        opts.key_end = *end == ',' ? strtol(end + 1, &end, 10) : 0;
+                        if (*end != '\0' || opts.key_start < 1 || opts.key_end < 0) {
+                            fprintf(stderr, "sort: invalid key: %s\n", value);
+                            return 0;
+                        }
+                    } else {
+                        budget = strtoull(value, &end, 10);
+                        if (*end == 'K' || *end == 'k') budget <<= 10, end++;
+                        else if (*end == 'M' || *end == 'm') budget <<= 20, end++;
+                        else if (*end == 'G' || *end == 'g') budget <<= 30, end++;
+                        if (*end != '\0' || budget < (1 << 16)) { // 최소 64KiB
+                            fprintf(stderr, "sort: invalid buffer size: %s\n", value);
+                            return 0;
+                        }
+                    }
+                    break;
+                } else {
+                    fprintf(stderr, "sort: invalid option -- '%c'\n", *opt);
+                    return 0;
+                }
+            }
+        }
+        sort_files(&argv[i], budget, &opts);
+        return 0;
+    }
+
+    // grep 명령어 구현 (고정 문자열 + '^', '$' 고정, -v -c -n, 파일이 없으면 표준 입력)
+    if (strcmp(argv[0], "grep") == 0) {
+        struct grep_state st = { 0 };
+        int i = 1;
+        for (; argv[i] != NULL && argv[i][0] == '-' && argv[i][1] != '\0'; i++) {
+            for (char *opt = argv[i] + 1; *opt; opt++) {
+                if (*opt == 'v') st.invert = 1;
+                else if (*opt == 'c') st.count_only = 1;
+                else if (*opt == 'n') st.line_numbers = 1;
+                else {
+                    fprintf(stderr, "grep: invalid option -- '%c'\n", *opt);
+                    return 0;
+                }
+            }
+        }
+        if (argv[i] == NULL) {
+            fprintf(stderr, "Usage: grep [-vcn] <pattern> [file...]\n");
+            return 0;
+        }
+        st.pattern = argv[i++];
+        st.plen = strlen(st.pattern);
+        if (st.plen > 0 && st.pattern[0] == '^') {
+            st.anchor_start = 1;
+            st.pattern++;
+            st.plen--;
+        }
+        if (st.plen > 0 && st.pattern[st.plen - 1] == '$') {
+            st.anchor_end = 1;
+            st.plen--;
+        }
+
+        int multiple = argv[i] != NULL && argv[i + 1] != NULL;
+        for (int first = i; argv[i] != NULL || i == first; i++) {
+            int fd = argv[i] != NULL ? open(argv[i], O_RDONLY) : STDIN_FILENO;
+            if (fd < 0) {
+                perror("grep");
+                continue;
+            }
+            st.label = multiple ? argv[i] : NULL;
+            st.lineno = 0;
+            st.matches = 0;
+            if (for_each_block(fd, 1, grep_block, &st) != 0) {
+                perror("grep: read");
+            }
+            if (fd != STDIN_FILENO) close(fd);
+            if (st.count_only) {
+                if (st.label != NULL) printf("%s:", st.label);
+                printf("%llu\n", (unsigned long long)st.matches);
+            }
+            if (argv[i] == NULL) break;
+        }
+        fflush(stdout);
+        return 0;
+    }
     
     // 기타 명령어는 처리되지 않음
     return 1;
@@ -245,4 +533,1118 @@ void execute_command(char **argv) {
     } else {
         perror("fork failed"); // fork 실패 시 에러 출력
     }
+}
+
+// ---- 체크섬 구현 (CPU 기능에 따라 SIMD/하드웨어 명령 또는 스칼라 코드 선택) ----
+
+static uint32_t crc32c_table[256]; // 스칼라 CRC32C 테이블 (반전 다항식 0x82F63B78)
+
+// 스칼라 CRC32C (바이트 단위 테이블 방식)
+static uint32_t crc32c_scalar(uint32_t crc, const uint8_t *p, size_t len) {
+    if (crc32c_table[1] == 0) { // 첫 호출 시 테이블 생성
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82F63B78 & -(c & 1));
+            crc32c_table[i] = c;
+        }
+    }
+    while (len--) crc = (crc >> 8) ^ crc32c_table[(crc ^ *p++) & 0xff];
+    return crc;
+}
+
+#if defined(__x86_64__)
+// SSE4.2 crc32 명령어를 사용하는 CRC32C (8바이트 단위)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p, size_t len) {
+    uint64_t c = crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+    }
+    crc = (uint32_t)c;
+    while (len--) crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+    static uint32_t (*impl)(uint32_t, const uint8_t *, size_t) = NULL;
+    if (impl == NULL) { // 첫 호출 시 CPU 기능 확인
+        impl = crc32c_scalar;
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("sse4.2")) impl = crc32c_sse42;
+#endif
+    }
+    return ~impl(~crc, data, len);
+}
+
+#define XXH_PRIME32_1 0x9E3779B1U
+#define XXH_PRIME32_2 0x85EBCA77U
+#define XXH_PRIME32_3 0xC2B2AE3DU
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+#define XXH_SECRET_SIZE 192
+#define XXH_STRIPE_LEN 64
+#define XXH_STRIPES_PER_BLOCK ((XXH_SECRET_SIZE - XXH_STRIPE_LEN) / 8)
+
+// xxHash3 기본 secret
+static const uint8_t xxh3_secret[XXH_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static uint64_t xxh_read64(const uint8_t *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static uint32_t xxh_read32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static uint64_t xxh_rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// 64x64 -> 128비트 곱의 상위/하위 XOR
+static uint64_t xxh_mul128_fold64(uint64_t a, uint64_t b) {
+    __uint128_t product = (__uint128_t)a * b;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+static uint64_t xxh3_avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+static uint64_t xxh64_avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    return h ^ (h >> 32);
+}
+
+static uint64_t xxh3_mix16(const uint8_t *p, const uint8_t *secret) {
+    return xxh_mul128_fold64(xxh_read64(p) ^ xxh_read64(secret), xxh_read64(p + 8) ^ xxh_read64(secret + 8));
+}
+
+// 64바이트 stripe 하나를 누산기 8개에 더함 (스칼라)
+static void xxh3_accumulate_scalar(uint64_t *acc, const uint8_t *p, const uint8_t *secret, size_t nb_stripes) {
+    for (size_t s = 0; s < nb_stripes; s++, p += XXH_STRIPE_LEN, secret += 8) {
+        for (int i = 0; i < 8; i++) {
+            uint64_t data_val = xxh_read64(p + 8 * i);
+            uint64_t data_key = data_val ^ xxh_read64(secret + 8 * i);
+            acc[i ^ 1] += data_val;
+            acc[i] += (uint32_t)data_key * (data_key >> 32);
+        }
+    }
+}
+
+static void xxh3_scramble_scalar(uint64_t *acc, const uint8_t *secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= xxh_read64(secret + 8 * i);
+        acc[i] = a * XXH_PRIME32_1;
+    }
+}
+
+#if defined(__x86_64__)
+// AVX2 버전: 누산기 8개를 256비트 레지스터 2개로 처리
+__attribute__((target("avx2")))
+static void xxh3_accumulate_avx2(uint64_t *acc, const uint8_t *p, const uint8_t *secret, size_t nb_stripes) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i *)acc);
+    __m256i a1 = _mm256_loadu_si256((const __m256i *)(acc + 4));
+    for (size_t s = 0; s < nb_stripes; s++, p += XXH_STRIPE_LEN, secret += 8) {
+        __m256i d0 = _mm256_loadu_si256((const __m256i *)p);
+        __m256i d1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+        __m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i *)secret));
+        __m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i *)(secret + 32)));
+        __m256i m0 = _mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32));
+        __m256i m1 = _mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32));
+        a0 = _mm256_add_epi64(a0, _mm256_add_epi64(m0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+        a1 = _mm256_add_epi64(a1, _mm256_add_epi64(m1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+    _mm256_storeu_si256((__m256i *)acc, a0);
+    _mm256_storeu_si256((__m256i *)(acc + 4), a1);
+}
+
+__attribute__((target("avx2")))
+static void xxh3_scramble_avx2(uint64_t *acc, const uint8_t *secret) {
+    const __m256i prime = _mm256_set1_epi32((int)XXH_PRIME32_1);
+    for (int i = 0; i < 8; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(acc + i));
+        a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *)(secret + 8 * i)));
+        __m256i lo = _mm256_mul_epu32(a, prime);
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        _mm256_storeu_si256((__m256i *)(acc + i), _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+    }
+}
+#endif
+
+static void (*xxh3_accumulate)(uint64_t *, const uint8_t *, const uint8_t *, size_t) = NULL;
+static void (*xxh3_scramble)(uint64_t *, const uint8_t *) = NULL;
+
+// 첫 호출 시 CPU 기능을 확인하여 누산/섞기 구현 선택
+static void xxh3_select(void) {
+    if (xxh3_accumulate != NULL) return;
+    xxh3_accumulate = xxh3_accumulate_scalar;
+    xxh3_scramble = xxh3_scramble_scalar;
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        xxh3_accumulate = xxh3_accumulate_avx2;
+        xxh3_scramble = xxh3_scramble_avx2;
+    }
+#endif
+}
+
+static const uint64_t xxh3_acc_init[8] = {
+    XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+    XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1,
+};
+
+// 누산기 8개를 하나의 64비트 해시로 병합
+static uint64_t xxh3_merge(const uint64_t *acc, uint64_t len) {
+    uint64_t result = len * XXH_PRIME64_1;
+    for (int i = 0; i < 4; i++) {
+        result += xxh_mul128_fold64(acc[2 * i] ^ xxh_read64(xxh3_secret + 11 + 16 * i),
+                                    acc[2 * i + 1] ^ xxh_read64(xxh3_secret + 11 + 16 * i + 8));
+    }
+    return xxh3_avalanche(result);
+}
+
+// 240바이트 초과 입력: 1KiB 블록 단위로 누산 후 병합
+static uint64_t xxh3_hash_long(const uint8_t *p, size_t len) {
+    xxh3_select();
+
+    uint64_t acc[8];
+    memcpy(acc, xxh3_acc_init, sizeof(acc));
+    const size_t block_len = XXH_STRIPE_LEN * XXH_STRIPES_PER_BLOCK;
+    size_t nb_blocks = (len - 1) / block_len;
+    for (size_t n = 0; n < nb_blocks; n++) {
+        xxh3_accumulate(acc, p + n * block_len, xxh3_secret, XXH_STRIPES_PER_BLOCK);
+        xxh3_scramble(acc, xxh3_secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN);
+    }
+    size_t nb_stripes = ((len - 1) - block_len * nb_blocks) / XXH_STRIPE_LEN;
+    xxh3_accumulate(acc, p + nb_blocks * block_len, xxh3_secret, nb_stripes);
+    xxh3_accumulate(acc, p + len - XXH_STRIPE_LEN, xxh3_secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 7, 1);
+    return xxh3_merge(acc, len);
+}
+
+uint64_t xxh3_64(const void *data, size_t len) {
+    const uint8_t *p = data;
+    const uint8_t *secret = xxh3_secret;
+
+    if (len == 0) {
+        return xxh64_avalanche(xxh_read64(secret + 56) ^ xxh_read64(secret + 64));
+    }
+    if (len <= 3) {
+        uint32_t combined = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24)
+                            | (uint32_t)p[len - 1] | ((uint32_t)len << 8);
+        uint64_t bitflip = xxh_read32(secret) ^ xxh_read32(secret + 4);
+        return xxh64_avalanche(combined ^ bitflip);
+    }
+    if (len <= 8) {
+        uint64_t bitflip = xxh_read64(secret + 8) ^ xxh_read64(secret + 16);
+        uint64_t input64 = xxh_read32(p + len - 4) + ((uint64_t)xxh_read32(p) << 32);
+        uint64_t h = input64 ^ bitflip;
+        h ^= xxh_rotl64(h, 49) ^ xxh_rotl64(h, 24);
+        h *= 0x9FB21C651E98DF25ULL;
+        h ^= (h >> 35) + len;
+        h *= 0x9FB21C651E98DF25ULL;
+        return h ^ (h >> 28);
+    }
+    if (len <= 16) {
+        uint64_t lo = xxh_read64(p) ^ (xxh_read64(secret + 24) ^ xxh_read64(secret + 32));
+        uint64_t hi = xxh_read64(p + len - 8) ^ (xxh_read64(secret + 40) ^ xxh_read64(secret + 48));
+        uint64_t acc = len + __builtin_bswap64(lo) + hi + xxh_mul128_fold64(lo, hi);
+        return xxh3_avalanche(acc);
+    }
+    if (len <= 128) {
+        uint64_t acc = len * XXH_PRIME64_1;
+        if (len > 32) {
+            if (len > 64) {
+                if (len > 96) {
+                    acc += xxh3_mix16(p + 48, secret + 96);
+                    acc += xxh3_mix16(p + len - 64, secret + 112);
+                }
+                acc += xxh3_mix16(p + 32, secret + 64);
+                acc += xxh3_mix16(p + len - 48, secret + 80);
+            }
+            acc += xxh3_mix16(p + 16, secret + 32);
+            acc += xxh3_mix16(p + len - 32, secret + 48);
+        }
+        acc += xxh3_mix16(p, secret);
+        acc += xxh3_mix16(p + len - 16, secret + 16);
+        return xxh3_avalanche(acc);
+    }
+    if (len <= 240) {
+        uint64_t acc = len * XXH_PRIME64_1;
+        int nb_rounds = (int)len / 16;
+        for (int i = 0; i < 8; i++) acc += xxh3_mix16(p + 16 * i, secret + 16 * i);
+        acc = xxh3_avalanche(acc);
+        for (int i = 8; i < nb_rounds; i++) acc += xxh3_mix16(p + 16 * i, secret + 16 * (i - 8) + 3);
+        acc += xxh3_mix16(p + len - 16, secret + 136 - 17);
+        return xxh3_avalanche(acc);
+    }
+    return xxh3_hash_long(p, len);
+}
+
+void xxh3_init(struct xxh3_state *st) {
+    xxh3_select();
+    memcpy(st->acc, xxh3_acc_init, sizeof(st->acc));
+    st->stripes = 0;
+    st->total = 0;
+    st->buffered = 0;
+}
+
+// 스트라이프 n개를 누산 (블록이 끝날 때마다 섞기). 뒤에 입력이 더 남아 있을 때만 호출해야
+// 한 번에 계산할 때와 같은 스트라이프가 처리됨 (마지막 스트라이프는 xxh3_digest에서 따로 처리)
+static void xxh3_consume(struct xxh3_state *st, const uint8_t *p, size_t n) {
+    while (n > 0) {
+        size_t k = XXH_STRIPES_PER_BLOCK - st->stripes;
+        if (k > n) k = n;
+        xxh3_accumulate(st->acc, p, xxh3_secret + st->stripes * 8, k);
+        st->stripes += k;
+        p += k * XXH_STRIPE_LEN;
+        n -= k;
+        if (st->stripes == XXH_STRIPES_PER_BLOCK) {
+            xxh3_scramble(st->acc, xxh3_secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN);
+            st->stripes = 0;
+        }
+    }
+}
+
+void xxh3_update(struct xxh3_state *st, const void *data, size_t len) {
+    const uint8_t *p = data;
+    st->total += len;
+    while (len > 0) {
+        if (st->buffered == XXH3_BUFFER_SIZE) { // 버퍼가 찼고 뒤에 입력이 더 있음: 버퍼 전체 처리
+            xxh3_consume(st, st->buffer, XXH3_BUFFER_SIZE / XXH_STRIPE_LEN);
+            memcpy(st->last, st->buffer + XXH3_BUFFER_SIZE - XXH_STRIPE_LEN, XXH_STRIPE_LEN);
+            st->buffered = 0;
+        }
+        if (st->buffered == 0 && len > XXH3_BUFFER_SIZE) { // 큰 입력은 버퍼를 거치지 않고 처리 (마지막 1~64바이트는 남김)
+            size_t n = (len - 1) / XXH_STRIPE_LEN;
+            xxh3_consume(st, p, n);
+            memcpy(st->last, p + (n - 1) * XXH_STRIPE_LEN, XXH_STRIPE_LEN);
+            p += n * XXH_STRIPE_LEN;
+            len -= n * XXH_STRIPE_LEN;
+            continue;
+        }
+        size_t take = XXH3_BUFFER_SIZE - st->buffered;
+        if (take > len) take = len;
+        memcpy(st->buffer + st->buffered, p, take);
+        st->buffered += take;
+        p += take;
+        len -= take;
+    }
+}
+
+uint64_t xxh3_digest(struct xxh3_state *st) {
+    if (st->total <= XXH3_BUFFER_SIZE) return xxh3_64(st->buffer, st->total); // 처리한 스트라이프 없음
+
+    // 남은 입력 중 마지막 바이트 전까지의 스트라이프 처리 후, 입력 끝 64바이트를 마지막 스트라이프로
+    size_t n = (st->buffered - 1) / XXH_STRIPE_LEN;
+    xxh3_consume(st, st->buffer, n);
+    uint8_t tail[XXH_STRIPE_LEN];
+    if (st->buffered >= XXH_STRIPE_LEN) {
+        memcpy(tail, st->buffer + st->buffered - XXH_STRIPE_LEN, XXH_STRIPE_LEN);
+    } else { // 끝 스트라이프가 이전에 처리한 데이터에 걸침
+        size_t from_last = XXH_STRIPE_LEN - st->buffered;
+        memcpy(tail, st->last + st->buffered, from_last);
+        memcpy(tail + from_last, st->buffer, st->buffered);
+    }
+    xxh3_accumulate(st->acc, tail, xxh3_secret + XXH_SECRET_SIZE - XXH_STRIPE_LEN - 7, 1);
+    return xxh3_merge(st->acc, st->total);
+}
+
+// 현재 시각 (초 단위, 처리 속도 계산용)
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 복사하면서 CRC32C를 계산하고, 대상 파일을 다시 읽어 비교
+void copy_verify(const char *src, const char *dest) {
+    int src_fd = open(src, O_RDONLY);
+    if (src_fd < 0) {
+        perror("cp: open source");
+        return;
+    }
+    int dest_fd = open(dest, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (dest_fd < 0) {
+        perror("cp: open destination");
+        close(src_fd);
+        return;
+    }
+    char *buffer = malloc(IO_CHUNK);
+    if (buffer == NULL) {
+        perror("cp: malloc");
+        close(src_fd);
+        close(dest_fd);
+        return;
+    }
+    posix_fadvise(src_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // 1단계: 복사하면서 원본 체크섬 계산
+    uint32_t src_crc = 0;
+    off_t total = 0;
+    ssize_t bytes;
+    double start = now_seconds();
+    while ((bytes = read(src_fd, buffer, IO_CHUNK)) > 0) {
+        src_crc = crc32c(src_crc, buffer, bytes);
+        for (ssize_t done = 0; done < bytes; ) {
+            ssize_t n = write(dest_fd, buffer + done, bytes - done);
+            if (n < 0) {
+                perror("cp: write");
+                goto out;
+            }
+            done += n;
+        }
+        total += bytes;
+    }
+    if (bytes < 0) {
+        perror("cp: read");
+        goto out;
+    }
+    // 저장 장치에서 다시 읽도록 디스크에 기록하고 페이지 캐시에서 제거
+    if (fdatasync(dest_fd) != 0) {
+        perror("cp: fdatasync");
+        goto out;
+    }
+    posix_fadvise(dest_fd, 0, 0, POSIX_FADV_DONTNEED);
+    double copy_time = now_seconds() - start;
+
+    // 2단계: 대상 파일을 다시 읽어 체크섬 계산
+    uint32_t dest_crc = 0;
+    off_t verified = 0;
+    start = now_seconds();
+    while ((bytes = pread(dest_fd, buffer, IO_CHUNK, verified)) > 0) {
+        dest_crc = crc32c(dest_crc, buffer, bytes);
+        verified += bytes;
+    }
+    if (bytes < 0) {
+        perror("cp: read back");
+        goto out;
+    }
+    double verify_time = now_seconds() - start;
+
+    if (verified != total || dest_crc != src_crc) {
+        fprintf(stderr, "cp: verify failed: %s (crc32c %08x, %lld bytes) != %s (crc32c %08x, %lld bytes)\n",
+                src, src_crc, (long long)total, dest, dest_crc, (long long)verified);
+    } else {
+        printf("cp: verified %lld bytes, crc32c %08x (copy %.2f GB/s, verify %.2f GB/s)\n",
+               (long long)total, src_crc,
+               copy_time > 0 ? total / copy_time / 1e9 : 0.0,
+               verify_time > 0 ? total / verify_time / 1e9 : 0.0);
+    }
+
+out:
+    free(buffer);
+    close(src_fd);
+    close(dest_fd);
+}
+
+// ---- wc / grep 구현 (CPU 기능에 따라 AVX2/SSE4.2 또는 스칼라 코드 선택) ----
+
+// 스칼라 wc (공백: ' ', '\t', '\n', '\v', '\f', '\r')
+static void wc_count_scalar(struct wc_counts *c, const uint8_t *p, size_t len) {
+    int in_word = c->in_word;
+    for (size_t i = 0; i < len; i++) {
+        int space = p[i] == ' ' || (uint8_t)(p[i] - '\t') <= 4;
+        c->lines += p[i] == '\n';
+        c->words += !space && !in_word; // 공백 다음의 첫 글자가 단어 시작
+        in_word = !space;
+    }
+    c->in_word = in_word;
+    c->bytes += len;
+}
+
+#if defined(__x86_64__)
+// AVX2 wc: 32바이트씩 줄바꿈/공백 비트마스크를 만들어 popcount
+__attribute__((target("avx2,popcnt")))
+static void wc_count_avx2(struct wc_counts *c, const uint8_t *p, size_t len) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i blank = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8(4);
+    uint64_t lines = 0, words = 0;
+    uint32_t prev_space = !c->in_word; // 직전 바이트가 공백이면 1
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i d = _mm256_sub_epi8(v, tab); // '\t'..'\r' 범위 검사: (v - '\t') <= 4
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(d, four), d),
+                                        _mm256_cmpeq_epi8(v, blank));
+        uint32_t nl_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline));
+        uint32_t sp_mask = _mm256_movemask_epi8(space);
+        uint32_t starts = ~sp_mask & ((sp_mask << 1) | prev_space);
+        lines += __builtin_popcount(nl_mask);
+        words += __builtin_popcount(starts);
+        prev_space = sp_mask >> 31;
+    }
+    c->lines += lines;
+    c->words += words;
+    c->bytes += i;
+    c->in_word = !prev_space;
+    wc_count_scalar(c, p + i, len - i); // 32바이트 미만 나머지
+}
+#endif
+
+void wc_count(struct wc_counts *c, const char *p, size_t len) {
+    static void (*impl)(struct wc_counts *, const uint8_t *, size_t) = NULL;
+    if (impl == NULL) { // 첫 호출 시 CPU 기능 확인
+        impl = wc_count_scalar;
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) impl = wc_count_avx2;
+#endif
+    }
+    impl(c, (const uint8_t *)p, len);
+}
+
+void wc_block(void *ctx, const char *p, size_t len) {
+    wc_count(ctx, p, len);
+}
+
+void wc_print(const struct wc_counts *c, int show_lines, int show_words, int show_bytes, const char *name) {
+    uint64_t values[3];
+    int n = 0;
+    if (show_lines) values[n++] = c->lines;
+    if (show_words) values[n++] = c->words;
+    if (show_bytes) values[n++] = c->bytes;
+    for (int i = 0; i < n; i++) printf(i ? " %7llu" : "%7llu", (unsigned long long)values[i]);
+    if (name[0] != '\0') printf(" %s", name);
+    printf("\n");
+}
+
+static const char *find_substring_scalar(const char *hay, size_t len, const char *needle, size_t n) {
+    return memmem(hay, len, needle, n);
+}
+
+#if defined(__x86_64__)
+// AVX2 검색: 첫 글자와 마지막 글자가 모두 맞는 위치만 골라 memcmp로 확인
+__attribute__((target("avx2,bmi")))
+static const char *find_substring_avx2(const char *hay, size_t len, const char *needle, size_t n) {
+    if (n < 2) return n == 0 ? hay : memchr(hay, needle[0], len);
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+    size_t i = 0;
+    for (; i + n - 1 + 32 <= len; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i *)(hay + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i *)(hay + i + n - 1));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                                                              _mm256_cmpeq_epi8(last, block_last)));
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, n - 2) == 0) return hay + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return memmem(hay + i, len - i, needle, n); // 남은 부분
+}
+
+// SSE4.2 검색: pcmpestri(equal ordered)로 16바이트 안의 후보 위치를 찾음
+__attribute__((target("sse4.2")))
+static const char *find_substring_sse42(const char *hay, size_t len, const char *needle, size_t n) {
+    if (n == 0) return hay;
+    char head[16] = { 0 };
+    int head_len = n < 16 ? (int)n : 16; // 16바이트 넘는 패턴은 앞 16바이트로 후보 검색
+    memcpy(head, needle, head_len);
+    const __m128i pattern = _mm_loadu_si128((const __m128i *)head);
+    const char *p = hay, *end = hay + len;
+    while (end - p >= 16) {
+        int idx = _mm_cmpestri(pattern, head_len, _mm_loadu_si128((const __m128i *)p), 16,
+                               _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ORDERED);
+        if (idx == 16) {
+            p += 16;
+        } else if ((size_t)(end - p - idx) >= n && memcmp(p + idx, needle, n) == 0) {
+            return p + idx;
+        } else if (idx + head_len > 16) { // 블록 끝에 걸친 부분 일치: 그 위치부터 다시 검사
+            p += idx;
+        } else {
+            p += idx + 1;
+        }
+    }
+    return memmem(p, end - p, needle, n); // 16바이트 미만 나머지
+}
+#endif
+
+const char *find_substring(const char *hay, size_t len, const char *needle, size_t n) {
+    static const char *(*impl)(const char *, size_t, const char *, size_t) = NULL;
+    if (impl == NULL) { // 첫 호출 시 CPU 기능 확인
+        impl = find_substring_scalar;
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) impl = find_substring_avx2;
+        else if (__builtin_cpu_supports("sse4.2")) impl = find_substring_sse42;
+#endif
+    }
+    return impl(hay, len, needle, n);
+}
+
+int for_each_block(int fd, int whole_lines, void (*fn)(void *, const char *, size_t), void *ctx) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) { // 일반 파일: 전체를 mmap
+        char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            fn(ctx, data, st.st_size);
+            munmap(data, st.st_size);
+            return 0;
+        }
+    }
+
+    // 파이프 등: IO_CHUNK 단위로 읽고, 줄 단위가 필요하면 불완전한 마지막 줄은 다음 블록으로 넘김
+    size_t cap = IO_CHUNK, filled = 0;
+    char *buf = malloc(cap);
+    if (buf == NULL) return -1;
+    ssize_t n;
+    while ((n = read(fd, buf + filled, cap - filled)) > 0) {
+        filled += n;
+        size_t usable = filled;
+        if (whole_lines) {
+            char *nl = memrchr(buf, '\n', filled);
+            usable = nl != NULL ? (size_t)(nl - buf + 1) : 0;
+            if (usable == 0 && filled == cap) { // 한 줄이 버퍼보다 긴 경우 버퍼 확장
+                char *bigger = realloc(buf, cap * 2);
+                if (bigger == NULL) break;
+                buf = bigger;
+                cap *= 2;
+                continue;
+            }
+        }
+        if (usable > 0) {
+            fn(ctx, buf, usable);
+            memmove(buf, buf + usable, filled - usable);
+            filled -= usable;
+        }
+    }
+    if (filled > 0) fn(ctx, buf, filled); // 줄바꿈 없이 끝난 마지막 줄
+    free(buf);
+    return n < 0 ? -1 : 0;
+}
+
+// 줄 하나 출력 (또는 -c이면 개수만 셈), lineno는 1부터 시작하는 줄 번호
+static void grep_emit(struct grep_state *st, const char *line, const char *line_end, uint64_t lineno) {
+    st->matches++;
+    if (st->count_only) return;
+    if (st->label != NULL) printf("%s:", st->label);
+    if (st->line_numbers) printf("%llu:", (unsigned long long)lineno);
+    fwrite(line, 1, line_end - line, stdout);
+    if (line_end == line || line_end[-1] != '\n') putchar('\n');
+}
+
+// [pos, end)에서 패턴이 나오는 다음 줄의 시작 위치 반환 (없으면 end)
+static const char *grep_next_match(struct grep_state *st, const char *pos, const char *end) {
+    for (const char *s = pos; s <= end; ) {
+        const char *hit = find_substring(s, end - s, st->pattern, st->plen);
+        if (hit == NULL) break;
+        const char *line = memrchr(pos, '\n', hit - pos);
+        line = line != NULL ? line + 1 : pos;
+        if ((!st->anchor_start || hit == line)
+            && (!st->anchor_end || hit + st->plen == end || hit[st->plen] == '\n')) {
+            return line;
+        }
+        s = hit + 1; // 고정 위치 조건이 맞지 않으면 다음 후보 검색
+    }
+    return end;
+}
+
+void grep_block(void *ctx, const char *p, size_t len) {
+    struct grep_state *st = ctx;
+    const char *pos = p, *end = p + len;
+    while (pos < end) {
+        const char *match = grep_next_match(st, pos, end);
+
+        // pos부터 match 전까지는 일치하지 않는 줄
+        if (st->invert) {
+            while (pos < match) {
+                const char *nl = memchr(pos, '\n', match - pos);
+                const char *line_end = nl != NULL ? nl + 1 : match;
+                grep_emit(st, pos, line_end, ++st->lineno);
+                pos = line_end;
+            }
+        } else if (st->line_numbers) {
+            struct wc_counts skipped = { 0 };
+            wc_count(&skipped, pos, match - pos);
+            st->lineno += skipped.lines;
+        }
+        if (match == end) break;
+
+        const char *nl = memchr(match, '\n', end - match);
+        const char *line_end = nl != NULL ? nl + 1 : end;
+        st->lineno++;
+        if (!st->invert) grep_emit(st, match, line_end, st->lineno);
+        pos = line_end;
+    }
+}
+
+// ---- sort 구현 (메모리 한도 내 병렬 run 생성 + 임시 파일 + loser tree k-way 병합) ----
+
+static struct sort_options sort_opts; // 정렬 중에는 읽기 전용 (스레드 공유)
+
+// 줄 하나의 위치와 키 (줄 데이터는 아레나에 두고 레코드 배열에는 위치만 저장)
+struct sort_rec {
+    uint64_t off;      // 아레나 안 줄 시작 위치
+    uint32_t len;      // 줄 길이 ('\n' 제외)
+    uint32_t key_off;  // 줄 시작 기준 키 위치
+    uint32_t key_len;  // 키 길이
+    double num;        // -n 키 값
+};
+
+// 필드 n개를 건너뛴 위치 (필드는 앞쪽 공백을 포함, GNU sort와 같은 규칙)
+static uint32_t sort_skip_fields(const char *line, uint32_t len, int n) {
+    uint32_t i = 0;
+    while (n-- > 0 && i < len) {
+        while (i < len && (line[i] == ' ' || line[i] == '\t')) i++;
+        while (i < len && line[i] != ' ' && line[i] != '\t') i++;
+    }
+    return i;
+}
+
+// -n 키 값 (앞쪽 공백, '-' 부호, 소수점 허용, 숫자가 아니면 0)
+static double sort_parse_number(const char *p, uint32_t len) {
+    uint32_t i = 0;
+    while (i < len && (p[i] == ' ' || p[i] == '\t')) i++;
+    int negative = i < len && p[i] == '-';
+    if (negative) i++;
+    double value = 0;
+    for (; i < len && p[i] >= '0' && p[i] <= '9'; i++) value = value * 10 + (p[i] - '0');
+    if (i < len && p[i] == '.') {
+        double scale = 0.1;
+        for (i++; i < len && p[i] >= '0' && p[i] <= '9'; i++, scale /= 10) value += (p[i] - '0') * scale;
+    }
+    return negative ? -value : value;
+}
+
+// 줄의 키 위치와 숫자 값 계산
+static void sort_make_key(const char *line, uint32_t len, struct sort_rec *r) {
+    uint32_t beg = 0, end = len;
+    if (sort_opts.key_start > 0) {
+        beg = sort_skip_fields(line, len, sort_opts.key_start - 1);
+        if (sort_opts.key_end > 0) {
+            end = sort_skip_fields(line, len, sort_opts.key_end);
+            if (end < beg) end = beg;
+        }
+    }
+    r->key_off = beg;
+    r->key_len = end - beg;
+    if (sort_opts.numeric) r->num = sort_parse_number(line + beg, end - beg);
+}
+
+static int sort_bytes(const char *a, uint32_t alen, const char *b, uint32_t blen) {
+    int c = memcmp(a, b, alen < blen ? alen : blen);
+    return c != 0 ? c : (alen > blen) - (alen < blen);
+}
+
+// 두 줄 비교 (키가 같으면 -u가 아닌 경우 줄 전체로 비교)
+static int sort_compare(const char *a, const struct sort_rec *ra, const char *b, const struct sort_rec *rb) {
+    int c;
+    if (sort_opts.numeric) c = (ra->num > rb->num) - (ra->num < rb->num);
+    else c = sort_bytes(a + ra->key_off, ra->key_len, b + rb->key_off, rb->key_len);
+    if (c == 0 && !sort_opts.unique && (sort_opts.numeric || sort_opts.key_start > 0)) {
+        c = sort_bytes(a, ra->len, b, rb->len);
+    }
+    return sort_opts.reverse ? -c : c;
+}
+
+// 레코드 비교 함수 (같은 줄은 입력 순서 유지)
+static int sort_rec_compare(const void *x, const void *y, void *arena) {
+    const struct sort_rec *a = x, *b = y;
+    int c = sort_compare((const char *)arena + a->off, a, (const char *)arena + b->off, b);
+    return c != 0 ? c : (a->off > b->off) - (a->off < b->off);
+}
+
+// 버퍼를 거쳐 디스크립터에 쓰기
+struct sort_writer {
+    int fd;
+    char *buf;
+    size_t cap;   // 버퍼 크기 (-S 한도에 포함)
+    size_t used;
+    int error;
+};
+
+static void sort_flush(struct sort_writer *w) {
+    for (size_t done = 0; done < w->used && !w->error; ) {
+        ssize_t n = write(w->fd, w->buf + done, w->used - done);
+        if (n < 0) {
+            perror("sort: write");
+            w->error = 1;
+        } else {
+            done += n;
+        }
+    }
+    w->used = 0;
+}
+
+static void sort_write_line(struct sort_writer *w, const char *line, size_t len) {
+    while (len + 1 > w->cap - w->used) { // 버퍼에 다 들어가지 않으면 나누어 쓰기
+        size_t part = w->cap - w->used < len ? w->cap - w->used : len;
+        memcpy(w->buf + w->used, line, part);
+        w->used += part;
+        line += part;
+        len -= part;
+        sort_flush(w);
+    }
+    memcpy(w->buf + w->used, line, len);
+    w->buf[w->used + len] = '\n';
+    w->used += len + 1;
+}
+
+// 병합 입력 하나: 메모리 run (정렬된 레코드 배열) 또는 임시 파일 run
+struct sort_source {
+    const char *arena;       // 메모리 run
+    struct sort_rec *recs;
+    size_t nrecs, pos;
+    int fd;                  // 파일 run (-1이면 메모리 run)
+    char *buf;
+    size_t cap, start, end;
+    int eof;
+    const char *line;        // 현재 줄 (NULL이면 끝)
+    struct sort_rec rec;     // 현재 줄의 키
+};
+
+// 다음 줄로 이동
+static void sort_source_next(struct sort_source *s) {
+    if (s->fd < 0) {
+        if (s->pos == s->nrecs) {
+            s->line = NULL;
+            return;
+        }
+        s->rec = s->recs[s->pos++];
+        s->line = s->arena + s->rec.off;
+        return;
+    }
+    while (1) {
+        char *nl = memchr(s->buf + s->start, '\n', s->end - s->start);
+        if (nl != NULL) {
+            s->line = s->buf + s->start;
+            s->rec.len = nl - s->line;
+            sort_make_key(s->line, s->rec.len, &s->rec);
+            s->start = nl - s->buf + 1;
+            return;
+        }
+        if (s->eof) { // run 파일은 항상 '\n'으로 끝남
+            s->line = NULL;
+            return;
+        }
+        memmove(s->buf, s->buf + s->start, s->end - s->start);
+        s->end -= s->start;
+        s->start = 0;
+        if (s->end == s->cap) { // 한 줄이 버퍼보다 긴 경우 확장
+            char *bigger = realloc(s->buf, s->cap * 2);
+            if (bigger == NULL) {
+                perror("sort: realloc");
+                s->eof = 1;
+                continue;
+            }
+            s->buf = bigger;
+            s->cap *= 2;
+        }
+        ssize_t n = read(s->fd, s->buf + s->end, s->cap - s->end);
+        if (n <= 0) s->eof = 1;
+        else s->end += n;
+    }
+}
+
+// loser tree: tree[1..k-1]에는 각 경기의 패자, tree[0]에는 전체 승자 (끝난 입력은 항상 패배)
+static int sort_less(struct sort_source *src, int a, int b) {
+    if (src[a].line == NULL) return 0;
+    if (src[b].line == NULL) return 1;
+    int c = sort_compare(src[a].line, &src[a].rec, src[b].line, &src[b].rec);
+    return c < 0 || (c == 0 && a < b); // 같으면 앞선 run 우선 (입력 순서 유지)
+}
+
+static int sort_tree_init(struct sort_source *src, int *tree, int k, int node) {
+    if (node >= k) return node - k; // 잎 노드 = 입력 번호
+    int left = sort_tree_init(src, tree, k, 2 * node);
+    int right = sort_tree_init(src, tree, k, 2 * node + 1);
+    if (sort_less(src, right, left)) {
+        tree[node] = left;
+        return right;
+    }
+    tree[node] = right;
+    return left;
+}
+
+// k개의 입력을 병합하여 w에 출력 (-u이면 키가 같은 줄은 처음 것만)
+static int sort_merge(struct sort_source *src, int k, struct sort_writer *w) {
+    int *tree = malloc(k * sizeof(int));
+    char *last = NULL;           // -u: 마지막으로 출력한 줄 사본
+    size_t last_cap = 0;
+    struct sort_rec last_rec;
+    int have_last = 0;
+    if (tree == NULL) return -1;
+
+    for (int i = 0; i < k; i++) sort_source_next(&src[i]);
+    tree[0] = sort_tree_init(src, tree, k, 1);
+
+    while (src[tree[0]].line != NULL && !w->error) {
+        int winner = tree[0];
+        struct sort_source *s = &src[winner];
+        if (!sort_opts.unique || !have_last || sort_compare(last, &last_rec, s->line, &s->rec) != 0) {
+            sort_write_line(w, s->line, s->rec.len);
+            if (sort_opts.unique) {
+                if (s->rec.len > last_cap) {
+                    last_cap = s->rec.len * 2;
+                    free(last);
+                    last = malloc(last_cap);
+                    if (last == NULL) break;
+                }
+                memcpy(last, s->line, s->rec.len);
+                last_rec = s->rec;
+                have_last = 1;
+            }
+        }
+        sort_source_next(s);
+        for (int t = (winner + k) / 2; t > 0; t /= 2) { // 승자의 경로만 다시 경기
+            if (sort_less(src, tree[t], winner)) {
+                int loser = winner;
+                winner = tree[t];
+                tree[t] = loser;
+            }
+        }
+        tree[0] = winner;
+    }
+    sort_flush(w);
+    free(last);
+    free(tree);
+    return w->error ? -1 : 0;
+}
+
+// 이름 없는 임시 파일 생성 ($TMPDIR 또는 /tmp)
+// run은 항상 임시 파일에 씀: run을 만드는 것은 입력이 -S 한도를 넘었기 때문이므로
+// memfd(tmpfs 페이지)에 두면 한도 밖의 메모리를 쓰게 되어 하드 한도가 의미 없어짐
+static int sort_temp_file(void) {
+    const char *dir = getenv("TMPDIR");
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/shell-sort-XXXXXX", dir != NULL ? dir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("sort: temporary file");
+        return -1;
+    }
+    unlink(path);
+    return fd;
+}
+
+// 임시 파일 run들을 병합 (buffer는 입력 하나당 읽기 버퍼 크기)
+static int sort_merge_files(int *fds, int n, size_t buffer, struct sort_writer *w) {
+    struct sort_source *src = calloc(n, sizeof(*src));
+    int result = src == NULL ? -1 : 0;
+    for (int i = 0; i < n && result == 0; i++) {
+        lseek(fds[i], 0, SEEK_SET);
+        src[i].fd = fds[i];
+        src[i].cap = buffer;
+        src[i].buf = malloc(buffer);
+        if (src[i].buf == NULL) result = -1;
+    }
+    if (result == 0) result = sort_merge(src, n, w);
+    for (int i = 0; src != NULL && i < n; i++) free(src[i].buf);
+    free(src);
+    return result;
+}
+
+struct sort_slice {
+    struct sort_rec *recs;
+    struct sort_rec *scratch; // 병합 정렬용 보조 배열 (recs와 같은 크기)
+    size_t n;
+    char *arena;
+};
+
+// 레코드 병합 정렬: 작은 구간은 삽입 정렬 후 recs와 scratch를 번갈아 쓰며 두 배씩 합침
+// qsort_r는 내부에서 보조 배열을 malloc하므로 -S 한도에 넣을 수 있도록 직접 구현
+static void sort_recs(struct sort_rec *recs, struct sort_rec *scratch, size_t n, char *arena) {
+    const size_t base = 32;
+    for (size_t lo = 0; lo < n; lo += base) {
+        size_t hi = lo + base < n ? lo + base : n;
+        for (size_t i = lo + 1; i < hi; i++) {
+            struct sort_rec r = recs[i];
+            size_t j = i;
+            for (; j > lo && sort_rec_compare(&recs[j - 1], &r, arena) > 0; j--) recs[j] = recs[j - 1];
+            recs[j] = r;
+        }
+    }
+
+    struct sort_rec *from = recs, *to = scratch;
+    for (size_t width = base; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                to[k++] = sort_rec_compare(&from[j], &from[i], arena) < 0 ? from[j++] : from[i++];
+            }
+            memcpy(to + k, from + i, (mid - i) * sizeof(*to));
+            memcpy(to + k + (mid - i), from + j, (hi - j) * sizeof(*to));
+        }
+        struct sort_rec *tmp = from;
+        from = to;
+        to = tmp;
+    }
+    if (from != recs) memcpy(recs, from, n * sizeof(*recs));
+}
+
+static void *sort_slice_thread(void *arg) {
+    struct sort_slice *slice = arg;
+    sort_recs(slice->recs, slice->scratch, slice->n, slice->arena);
+    return NULL;
+}
+
+// 레코드 배열을 여러 스레드가 나누어 정렬한 뒤 병합하여 w에 출력
+static int sort_batch(char *arena, struct sort_rec *recs, struct sort_rec *scratch, size_t n, struct sort_writer *w) {
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads > SORT_MAX_THREADS) nthreads = SORT_MAX_THREADS;
+    if (nthreads > (long)(n / 4096) + 1) nthreads = n / 4096 + 1; // 작은 입력은 스레드 수 줄이기
+    if (nthreads < 1) nthreads = 1;
+
+    pthread_t threads[SORT_MAX_THREADS];
+    struct sort_slice slices[SORT_MAX_THREADS];
+    struct sort_source src[SORT_MAX_THREADS];
+    for (long t = 0; t < nthreads; t++) {
+        size_t from = n * t / nthreads, to = n * (t + 1) / nthreads;
+        slices[t] = (struct sort_slice){ recs + from, scratch + from, to - from, arena };
+        src[t] = (struct sort_source){ .arena = arena, .recs = recs + from, .nrecs = to - from, .fd = -1 };
+        if (t > 0 && pthread_create(&threads[t], NULL, sort_slice_thread, &slices[t]) != 0) {
+            sort_slice_thread(&slices[t]); // 스레드 생성 실패 시 직접 정렬
+            threads[t] = 0;
+        }
+    }
+    sort_slice_thread(&slices[0]);
+    for (long t = 1; t < nthreads; t++) {
+        if (threads[t] != 0) pthread_join(threads[t], NULL);
+    }
+    return sort_merge(src, nthreads, w);
+}
+
+int sort_files(char **files, size_t budget, const struct sort_options *opts) {
+    sort_opts = *opts;
+    // -S 한도 = 출력 버퍼 + 줄 데이터 50% + 레코드 배열과 정렬용 보조 배열 50%
+    size_t out_cap = budget / 16 < IO_CHUNK ? budget / 16 : IO_CHUNK;
+    size_t work = budget - out_cap;
+    size_t arena_cap = work / 2;
+    size_t rec_cap = (work - arena_cap) / (2 * sizeof(struct sort_rec));
+    char *arena = malloc(arena_cap);
+    struct sort_rec *recs = malloc(2 * rec_cap * sizeof(struct sort_rec));
+    struct sort_rec *scratch = recs + rec_cap;
+    char *out_buf = malloc(out_cap);
+    int *runs = NULL;   // 임시 파일 run 목록
+    int nruns = 0;
+    int result = -1;
+    if (arena == NULL || recs == NULL || out_buf == NULL) {
+        perror("sort: malloc");
+        goto out;
+    }
+
+    struct sort_writer out = { STDOUT_FILENO, out_buf, out_cap, 0, 0 };
+    fflush(stdout);
+
+    int file_idx = 0;
+    int fd = files[0] != NULL ? -1 : STDIN_FILENO; // 파일이 없으면 표준 입력
+    int input_done = 0;
+    size_t used = 0; // 아레나에 채운 크기 (이전 배치에서 넘어온 불완전한 줄 포함)
+
+    while (1) {
+        // 1단계: 아레나 채우기
+        while (!input_done && used < arena_cap) {
+            if (fd < 0) { // 다음 파일 열기
+                if (files[file_idx] == NULL) {
+                    input_done = 1;
+                    break;
+                }
+                fd = open(files[file_idx++], O_RDONLY);
+                if (fd < 0) {
+                    perror("sort");
+                    continue;
+                }
+                posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+            ssize_t n = read(fd, arena + used, arena_cap - used);
+            if (n > 0) {
+                used += n;
+                continue;
+            }
+            if (n < 0) perror("sort: read");
+            // 파일 끝: 마지막 줄에 '\n'이 없으면 붙임
+            if (used > 0 && arena[used - 1] != '\n') {
+                if (used == arena_cap) break; // 공간이 없으면 다음 배치에서 붙임
+                arena[used++] = '\n';
+            }
+            if (fd != STDIN_FILENO) close(fd);
+            fd = -1;
+            if (files[0] == NULL || files[file_idx] == NULL) input_done = 1;
+        }
+
+        // 2단계: 완전한 줄마다 레코드 생성
+        size_t n = 0, pos = 0;
+        while (n < rec_cap) {
+            char *nl = memchr(arena + pos, '\n', used - pos);
+            if (nl == NULL) break;
+            recs[n].off = pos;
+            recs[n].len = nl - (arena + pos);
+            sort_make_key(arena + pos, recs[n].len, &recs[n]);
+            n++;
+            pos = nl - arena + 1;
+        }
+        if (n == 0 && used == arena_cap) {
+            fprintf(stderr, "sort: line too long for buffer size, increase -S\n");
+            goto out;
+        }
+        int last_batch = input_done && pos == used;
+
+        // 3단계: 병렬 정렬 후 출력 (입력 전체가 한 배치면 바로 출력, 아니면 임시 파일 run으로)
+        if (last_batch && nruns == 0) {
+            result = sort_batch(arena, recs, scratch, n, &out);
+            goto out;
+        }
+        if (n > 0) {
+            int run_fd = sort_temp_file();
+            int *bigger = realloc(runs, (nruns + 1) * sizeof(int));
+            if (run_fd < 0 || bigger == NULL) goto out;
+            runs = bigger;
+            runs[nruns++] = run_fd;
+            struct sort_writer spill = { run_fd, out_buf, out_cap, 0, 0 };
+            if (sort_batch(arena, recs, scratch, n, &spill) != 0) goto out;
+        }
+        memmove(arena, arena + pos, used - pos);
+        used -= pos;
+        if (last_batch) break;
+    }
+
+    // 4단계: run 병합 (한 번에 SORT_MAX_RUNS개씩, 많으면 여러 단계로)
+    free(arena);
+    free(recs);
+    arena = NULL;
+    recs = NULL;
+    while (nruns > SORT_MAX_RUNS) {
+        int merged = 0;
+        for (int i = 0; i < nruns; i += SORT_MAX_RUNS) {
+            int group = nruns - i < SORT_MAX_RUNS ? nruns - i : SORT_MAX_RUNS;
+            int run_fd = sort_temp_file();
+            if (run_fd < 0) goto out;
+            struct sort_writer spill = { run_fd, out_buf, out_cap, 0, 0 };
+            if (sort_merge_files(runs + i, group, work / group, &spill) != 0) goto out;
+            for (int j = i; j < i + group; j++) close(runs[j]);
+            runs[merged++] = run_fd;
+        }
+        nruns = merged;
+    }
+    result = sort_merge_files(runs, nruns, work / nruns, &out);
+
+out:
+    for (int i = 0; i < nruns; i++) close(runs[i]);
+    free(runs);
+    free(arena);
+    free(recs);
+    free(out_buf);
+    return result;
 }
\ No newline at end of file